@@ -0,0 +1,19 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// --- AllocationCounter: process-wide heap allocation count ---
+// AllocationCounter.cpp replaces the global operator new/delete (and ImGui's allocator is
+// routed through CountedMalloc), so every heap allocation bumps one relaxed atomic. The
+// frame loop samples it once per frame; in steady state the difference should be zero.
+// SDL and driver allocations go through malloc directly and aren't counted.
+namespace AllocationCounter {
+    extern std::atomic<uint64_t> allocations;
+
+    inline uint64_t GetCount() { return allocations.load(std::memory_order_relaxed); }
+
+    // malloc/free with counting, for libraries that take allocator callbacks
+    void* CountedMalloc(size_t size, void* userData);
+    void CountedFree(void* ptr, void* userData);
+}
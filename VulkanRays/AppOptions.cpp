@@ -0,0 +1,189 @@
+#include "AppOptions.h"
+#include "Benchmark.h"
+#include "VulkanSwapchain.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+void printUsage(const char* exe) {
+    std::cerr
+        << "Usage: " << exe << " [options]\n"
+        << "  --headless WxH      render offscreen at WxH without a window or surface\n"
+        << "  --present-mode M    immediate | mailbox (default) | fifo | fifo_relaxed\n"
+        << "  --fps-limit N       cap the frame rate on the CPU (0 = off)\n"
+        << "  --record-threads N  record draws in parallel secondary command buffers (0 = inline, default)\n"
+        << "  --defrag-budget K   KiB of buffers the defragmenter may move per frame (default 256, 0 = off)\n"
+        << "  --draw-path P       ubo (default, dynamic UBO offset per draw) | bindless (one transform SSBO per frame)\n"
+        << "                      | push (MVP in push constants per draw)\n"
+        << "  --instanced         draw all pyramids as instances of one mesh in a single draw call\n"
+        << "  --gpu-culling       cull on the GPU and draw the survivors indirectly: instances (--instanced), or\n"
+        << "                      plain objects with --draw-path bindless (one indirect-count draw per mesh)\n"
+        << "  --no-draw-sort      draw in object order and bind everything per draw (the baseline for bind counts)\n"
+        << "  --frames N          exit after N frames (headless default: 1, bench: recorded frames, default 600)\n"
+        << "  --output DIR        headless: write each frame to DIR/frame_NNNNN.ppm\n"
+        << "  --bench SCENARIO    scripted camera benchmark (" << ListBenchScenarios() << ")\n"
+        << "  --warmup N          benchmark: frames to skip before recording (default 120)\n"
+        << "  --bench-threads L   benchmark: sweep record thread counts, e.g. 0,1,2,4,8 (one report, \"runs\" array)\n"
+        << "  --bench-draw-paths L benchmark: sweep draw paths, e.g. ubo,push,bindless (one report, \"runs\" array)\n"
+        << "  --report FILE       benchmark: write the JSON report to FILE instead of stdout\n"
+        << "  --trace FILE        write a Chrome trace of the CPU zones to FILE on exit (F9 dumps any time)\n"
+        << "  --trace-seconds S   how many seconds of history a trace dump covers (default 10)\n"
+        << "  --no-validation     do not enable VK_LAYER_KHRONOS_validation\n"
+        << "  --help              show this message\n";
+}
+
+bool parseExtent(const char* s, uint32_t& w, uint32_t& h) {
+    unsigned int pw = 0, ph = 0;
+    if (std::sscanf(s, "%ux%u", &pw, &ph) != 2 || pw == 0 || ph == 0) return false;
+    w = pw;
+    h = ph;
+    return true;
+}
+
+bool parseUInt(const char* s, uint32_t& out) {
+    char* end = nullptr;
+    unsigned long v = std::strtoul(s, &end, 10);
+    if (end == s || *end != '\0') return false;
+    out = static_cast<uint32_t>(v);
+    return true;
+}
+
+bool parseUIntList(const char* s, std::vector<uint32_t>& out) {
+    out.clear();
+    std::string list(s);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        uint32_t value = 0;
+        if (!parseUInt(list.substr(start, comma - start).c_str(), value)) return false;
+        out.push_back(value);
+        start = comma + 1;
+    }
+    return !out.empty();
+}
+
+bool parseDrawPathList(const char* s, std::vector<DrawPath>& out) {
+    out.clear();
+    std::string list(s);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        DrawPath path;
+        if (!ParseDrawPath(list.substr(start, comma - start).c_str(), path)) return false;
+        out.push_back(path);
+        start = comma + 1;
+    }
+    return !out.empty();
+}
+} // namespace
+
+bool ParseAppOptions(int argc, char** argv, AppOptions& out) {
+    bool framesGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--headless") == 0 && hasValue) {
+            out.headless = true;
+            if (!parseExtent(argv[++i], out.width, out.height)) {
+                std::cerr << "Invalid --headless extent '" << argv[i] << "', expected WxH\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--frames") == 0 && hasValue) {
+            if (!parseUInt(argv[++i], out.frames)) {
+                std::cerr << "Invalid --frames value '" << argv[i] << "'\n";
+                return false;
+            }
+            framesGiven = true;
+        } else if (std::strcmp(arg, "--present-mode") == 0 && hasValue) {
+            if (!ParsePresentMode(argv[++i], out.presentMode)) {
+                std::cerr << "Invalid --present-mode '" << argv[i] << "'\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--fps-limit") == 0 && hasValue) {
+            if (!parseUInt(argv[++i], out.fpsLimit)) {
+                std::cerr << "Invalid --fps-limit value '" << argv[i] << "'\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--defrag-budget") == 0 && hasValue) {
+            if (!parseUInt(argv[++i], out.defragBudgetKiB)) {
+                std::cerr << "Invalid --defrag-budget value '" << argv[i] << "'\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--draw-path") == 0 && hasValue) {
+            if (!ParseDrawPath(argv[++i], out.drawPath)) {
+                std::cerr << "Invalid --draw-path '" << argv[i] << "', expected bindless, ubo or push\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--record-threads") == 0 && hasValue) {
+            if (!parseUInt(argv[++i], out.recordThreads)) {
+                std::cerr << "Invalid --record-threads value '" << argv[i] << "'\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--bench-threads") == 0 && hasValue) {
+            if (!parseUIntList(argv[++i], out.benchThreadSweep)) {
+                std::cerr << "Invalid --bench-threads list '" << argv[i] << "', expected e.g. 0,1,2,4\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--output") == 0 && hasValue) {
+            out.outputDir = argv[++i];
+        } else if (std::strcmp(arg, "--bench-draw-paths") == 0 && hasValue) {
+            if (!parseDrawPathList(argv[++i], out.benchDrawPathSweep)) {
+                std::cerr << "Invalid --bench-draw-paths list '" << argv[i] << "', expected e.g. ubo,push,bindless\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--bench") == 0 && hasValue) {
+            out.benchScenario = argv[++i];
+            BenchScenario scenario;
+            if (!FindBenchScenario(out.benchScenario, scenario)) {
+                std::cerr << "Unknown benchmark scenario '" << out.benchScenario << "' (available: " << ListBenchScenarios() << ")\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--warmup") == 0 && hasValue) {
+            if (!parseUInt(argv[++i], out.warmupFrames)) {
+                std::cerr << "Invalid --warmup value '" << argv[i] << "'\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--report") == 0 && hasValue) {
+            out.benchReport = argv[++i];
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            out.traceFile = argv[++i];
+        } else if (std::strcmp(arg, "--trace-seconds") == 0 && hasValue) {
+            char* end = nullptr;
+            out.traceSeconds = std::strtod(argv[++i], &end);
+            if (end == argv[i] || *end != '\0' || out.traceSeconds <= 0.0) {
+                std::cerr << "Invalid --trace-seconds value '" << argv[i] << "'\n";
+                return false;
+            }
+        } else if (std::strcmp(arg, "--instanced") == 0) {
+            out.instanced = true;
+        } else if (std::strcmp(arg, "--gpu-culling") == 0) {
+            out.gpuCulling = true;
+        } else if (std::strcmp(arg, "--no-draw-sort") == 0) {
+            out.sortDraws = false;
+        } else if (std::strcmp(arg, "--no-validation") == 0) {
+            out.enableValidation = false;
+        } else {
+            if (std::strcmp(arg, "--help") != 0)
+                std::cerr << "Unknown or incomplete option '" << arg << "'\n";
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (!out.benchScenario.empty() && !framesGiven) out.frames = 600;
+    else if (out.headless && !framesGiven) out.frames = 1;
+    if (!out.benchThreadSweep.empty() && out.benchScenario.empty())
+        std::cerr << "Warning: --bench-threads only has an effect together with --bench\n";
+    if (!out.benchDrawPathSweep.empty() && out.benchScenario.empty())
+        std::cerr << "Warning: --bench-draw-paths only has an effect together with --bench\n";
+    if (!out.benchThreadSweep.empty() && !out.benchDrawPathSweep.empty()) {
+        std::cerr << "--bench-threads and --bench-draw-paths can't be combined, pick one sweep\n";
+        return false;
+    }
+    if (!out.outputDir.empty() && !out.headless)
+        std::cerr << "Warning: --output is only supported together with --headless\n";
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "VulkanPipeline.h"
+
+// Command-line configuration for VulkanApp
+struct AppOptions {
+    bool enableValidation = true;
+    // Headless: no SDL window, no surface, render into an offscreen color+depth target
+    bool headless = false;
+    uint32_t width = 1280, height = 720;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR; // falls back to FIFO if unsupported
+    uint32_t fpsLimit = 0;       // CPU frame limiter target (0 = off)
+    uint32_t frames = 0;         // stop after this many frames (0 = run until the window is closed)
+    uint32_t recordThreads = 0;  // record draws into secondary command buffers on N threads (0 = inline)
+    uint32_t defragBudgetKiB = 256; // device memory defragmentation: bytes moved per frame (0 = off)
+    DrawPath drawPath = DrawPath::DynamicUBO;
+    bool instanced = false;      // pyramids as one InstancedMeshObject, whatever the scene
+    bool gpuCulling = false;     // instanced scene: frustum-cull instances in a compute pass, draw indirect
+    bool sortDraws = true;       // state-sorted draw list; off = object order, every draw binds everything
+    std::string outputDir;       // headless only: write every rendered frame here as PPM
+    // Benchmark: scripted camera over a named scene, frames = recorded frames after warm-up
+    std::string benchScenario;   // empty = interactive
+    uint32_t warmupFrames = 120;
+    std::string benchReport;     // JSON report path (empty = stdout)
+    std::vector<uint32_t> benchThreadSweep; // rerun the benchmark once per record thread count
+    std::vector<DrawPath> benchDrawPathSweep; // ... or once per draw path (one sweep at a time)
+    // CPU trace (Chrome trace_event JSON): written on exit if traceFile is set, and on F9
+    std::string traceFile;
+    double traceSeconds = 10.0;  // how much history a dump covers
+};
+
+// Parses argv into out. Prints usage and returns false on bad input or --help.
+bool ParseAppOptions(int argc, char** argv, AppOptions& out);
@@ -0,0 +1,253 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+const BenchScenario kScenarios[] = {
+    // name            grid  spacing cols rows pyramidSpacing instanced
+    { "default",        20,   0.5f,    3,   1,   1.5f },
+    { "pyramids-1k",    25,   0.5f,   32,  32,   0.75f },
+    { "pyramids-10k",  150,   0.5f,  100, 100,   1.5f },
+    { "instanced-10k", 150,   0.5f,  100, 100,   1.5f,  true },
+    { "instanced-1m",  150,   0.5f, 1000, 1000,  0.75f, true },
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    // Nearest-rank percentile: stable for small sample counts and always an observed value
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+void writeStats(std::ostream& out, const char* name, std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    out << "    \"" << name << "\": { "
+        << "\"mean\": " << (values.empty() ? 0.0 : sum / values.size())
+        << ", \"p50\": " << percentile(values, 0.50)
+        << ", \"p95\": " << percentile(values, 0.95)
+        << ", \"p99\": " << percentile(values, 0.99)
+        << ", \"max\": " << (values.empty() ? 0.0 : values.back())
+        << ", \"samples\": " << values.size() << " }";
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+} // namespace
+
+bool FindBenchScenario(const std::string& name, BenchScenario& out) {
+    for (const auto& scenario : kScenarios) {
+        if (scenario.name == name) {
+            out = scenario;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string ListBenchScenarios() {
+    std::string names;
+    for (const auto& scenario : kScenarios) {
+        if (!names.empty()) names += ", ";
+        names += scenario.name;
+    }
+    return names;
+}
+
+// --- CameraPath ---
+CameraPath::CameraPath(float radius) {
+    // Alternate wide/high and close/low passes around the scene so both the far overview
+    // (many small objects) and close-ups (large triangles, overdraw) are measured
+    const int keyCount = 8;
+    for (int i = 0; i < keyCount; ++i) {
+        float angle = i * 6.2831853f / keyCount;
+        float r = radius * ((i % 2) ? 0.55f : 1.0f);
+        float y = (i % 2) ? 0.6f + 0.05f * radius : 1.5f + 0.35f * radius;
+        keys.push_back({ std::sin(angle) * r, y, std::cos(angle) * r });
+    }
+}
+
+CameraPose CameraPath::sample(uint64_t frame) const {
+    size_t n = keys.size();
+    size_t seg = (size_t)(frame / framesPerKey) % n;
+    float t = (frame % framesPerKey) / (float)framesPerKey;
+    const Key& p0 = keys[(seg + n - 1) % n];
+    const Key& p1 = keys[seg];
+    const Key& p2 = keys[(seg + 1) % n];
+    const Key& p3 = keys[(seg + 2) % n];
+    auto catmullRom = [t](float a, float b, float c, float d) {
+        float t2 = t * t, t3 = t2 * t;
+        return 0.5f * ((2.0f * b) + (-a + c) * t + (2.0f * a - 5.0f * b + 4.0f * c - d) * t2 + (-a + 3.0f * b - 3.0f * c + d) * t3);
+    };
+    CameraPose pose;
+    pose.x = catmullRom(p0.x, p1.x, p2.x, p3.x);
+    pose.y = catmullRom(p0.y, p1.y, p2.y, p3.y);
+    pose.z = catmullRom(p0.z, p1.z, p2.z, p3.z);
+    // Always look at the scene centre (same convention as the mouselook camera in VulkanApp)
+    float horizontal = std::sqrt(pose.x * pose.x + pose.z * pose.z);
+    pose.yaw = std::atan2(-pose.x, pose.z);
+    pose.pitch = std::atan2(-pose.y, horizontal);
+    return pose;
+}
+
+// --- Benchmark ---
+static float sceneRadius(const BenchScenario& scenario) {
+    float halfX = 0.5f * (scenario.pyramidCols - 1) * scenario.pyramidSpacing;
+    float halfZ = 0.5f * (scenario.pyramidRows - 1) * scenario.pyramidSpacing;
+    return std::max(2.5f, 1.2f * std::sqrt(halfX * halfX + halfZ * halfZ) + 1.5f);
+}
+
+Benchmark::Benchmark(const BenchScenario& scenario, uint32_t warmupFrames, uint32_t recordFrames)
+    : scenario(scenario), path(sceneRadius(scenario)), warmupFrames(warmupFrames), recordFrames(recordFrames) {
+    samples.reserve(recordFrames);
+}
+
+uint64_t Benchmark::endFrame(double cpuFrameMs, double cpuWaitMs, double cpuRecordMs, uint64_t heapAllocations) {
+    uint64_t index = frameIndex++;
+    if (index >= warmupFrames && index < (uint64_t)warmupFrames + recordFrames) {
+        BenchSample sample;
+        sample.cpuFrameMs = cpuFrameMs;
+        sample.cpuWaitMs = cpuWaitMs;
+        sample.cpuRecordMs = cpuRecordMs;
+        sample.heapAllocations = heapAllocations;
+        samples.push_back(sample);
+    }
+    return index;
+}
+
+void Benchmark::setGpuTime(uint64_t benchFrame, double gpuMs) {
+    if (isRecorded(benchFrame)) samples[benchFrame - warmupFrames].gpuMs = gpuMs;
+}
+
+bool Benchmark::ScopeKey::operator<(const ScopeKey& o) const {
+    if (depth != o.depth) return depth < o.depth;
+    if (index != o.index) return index < o.index;
+    return name != o.name && std::strcmp(name, o.name) < 0;
+}
+
+void Benchmark::addGpuScopes(uint64_t benchFrame, const std::vector<GpuScopeResult>& scopes) {
+    if (!isRecorded(benchFrame)) return;
+    for (const auto& scope : scopes) {
+        ScopeKey key{ scope.depth, scope.name, scope.index };
+        auto it = scopeLookup.find(key);
+        if (it == scopeLookup.end()) {
+            it = scopeLookup.emplace(key, scopeStats.size()).first;
+            ScopeStats stats;
+            stats.label = scope.name;
+            if (scope.index >= 0) stats.label += "[" + std::to_string(scope.index) + "]";
+            stats.depth = scope.depth;
+            scopeStats.push_back(stats);
+        }
+        ScopeStats& stats = scopeStats[it->second];
+        stats.sumMs += scope.ms;
+        stats.maxMs = std::max(stats.maxMs, scope.ms);
+        ++stats.count;
+    }
+}
+
+void WriteBenchReport(const std::string& path, const std::string& json) {
+    if (path.empty()) {
+        std::cout << json;
+        return;
+    }
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error("Failed to open benchmark report " + path);
+    file << json;
+}
+
+std::string Benchmark::buildReport(const BenchReportInfo& info) const {
+    std::vector<double> cpuFrame, cpuWork, cpuRecord, gpu;
+    uint64_t heapAllocations = 0, maxHeapAllocations = 0, allocatingFrames = 0;
+    for (const auto& s : samples) {
+        heapAllocations += s.heapAllocations;
+        maxHeapAllocations = std::max(maxHeapAllocations, s.heapAllocations);
+        if (s.heapAllocations) ++allocatingFrames;
+        cpuFrame.push_back(s.cpuFrameMs);
+        cpuRecord.push_back(s.cpuRecordMs);
+        cpuWork.push_back(std::max(0.0, s.cpuFrameMs - s.cpuWaitMs));
+        if (s.gpuMs >= 0.0) gpu.push_back(s.gpuMs);
+    }
+    std::ostringstream out;
+    out << "{\n"
+        << "  \"scenario\": \"" << jsonEscape(scenario.name) << "\",\n"
+        << "  \"device\": \"" << jsonEscape(info.deviceName) << "\",\n"
+        << "  \"resolution\": [" << info.width << ", " << info.height << "],\n"
+        << "  \"present_mode\": \"" << info.presentMode << "\",\n"
+        << "  \"validation\": " << (info.validation ? "true" : "false") << ",\n"
+        << "  \"objects\": " << info.objectCount << ",\n"
+        << "  \"instances\": " << info.instanceCount << ",\n";
+    if (info.gpuCulling)
+        out << "  \"gpu_culling\": { \"submitted\": " << info.cullSubmitted << ", \"drawn\": " << info.cullDrawn
+            << ", \"objects_submitted\": " << info.cullObjectsSubmitted << ", \"objects_drawn\": " << info.cullObjectsDrawn << " },\n";
+    else
+        out << "  \"gpu_culling\": null,\n";
+    out << "  \"draw_sort\": " << (info.drawSort ? "true" : "false") << ",\n"
+        << "  \"binds_per_frame\": { \"draws\": " << info.binds.draws << ", \"pipelines\": " << info.binds.pipelineBinds
+        << ", \"vertex_buffers\": " << info.binds.vertexBufferBinds << ", \"index_buffers\": " << info.binds.indexBufferBinds << " },\n"
+        << "  \"record_threads\": " << info.recordThreads << ",\n"
+        << "  \"draw_path\": \"" << info.drawPath << "\",\n"
+        << "  \"render_targets\": [";
+    for (size_t i = 0; i < info.renderTargets.size(); ++i) {
+        const BenchRenderTargets& rt = info.renderTargets[i];
+        out << (i ? ", " : "") << "{ \"resolution\": [" << rt.width << ", " << rt.height << "], \"committed_bytes\": "
+            << rt.committedBytes << ", \"unaliased_bytes\": " << rt.unaliasedBytes << ", \"lazy_bytes\": " << rt.lazyBytes << " }";
+    }
+    out << "],\n"
+        << "  \"memory\": {\n"
+        << "    \"budget_extension\": " << (info.memoryBudgetExtension ? "true" : "false") << ",\n"
+        << "    \"peak_bytes\": " << info.memoryPeakBytes << ",\n"
+        << "    \"fragmentation\": " << info.memoryFragmentation << ",\n"
+        << "    \"sparse_blocks\": " << info.memorySparseBlocks << ",\n"
+        << "    \"defrag_moved_bytes\": " << info.defragMovedBytes << ",\n"
+        << "    \"categories\": {";
+    for (size_t i = 0; i < info.memoryCategories.size(); ++i) {
+        const BenchMemoryCategory& c = info.memoryCategories[i];
+        out << (i ? ", " : " ") << "\"" << jsonEscape(c.name) << "\": { \"bytes\": " << c.bytes
+            << ", \"allocations\": " << c.allocations << " }";
+    }
+    out << " },\n"
+        << "    \"heaps\": [";
+    for (size_t i = 0; i < info.memoryHeaps.size(); ++i) {
+        const BenchMemoryHeap& h = info.memoryHeaps[i];
+        out << (i ? ", " : "") << "{ \"size\": " << h.size << ", \"budget\": " << h.budget << ", \"usage\": " << h.usage
+            << ", \"device_local\": " << (h.deviceLocal ? "true" : "false") << " }";
+    }
+    out << "]\n  },\n"
+        << "  \"heap_allocations\": { \"per_frame_mean\": " << (samples.empty() ? 0.0 : (double)heapAllocations / samples.size())
+        << ", \"per_frame_max\": " << maxHeapAllocations << ", \"frames_allocating\": " << allocatingFrames << " },\n"
+        << "  \"frame_arena\": { \"high_water_bytes\": " << info.frameArenaHighWater
+        << ", \"overflows\": " << info.frameArenaOverflows << " },\n"
+        << "  \"warmup_frames\": " << warmupFrames << ",\n"
+        << "  \"recorded_frames\": " << samples.size() << ",\n"
+        << "  \"timings_ms\": {\n";
+    writeStats(out, "cpu_frame", cpuFrame);
+    out << ",\n";
+    writeStats(out, "cpu_work", cpuWork);
+    out << ",\n";
+    writeStats(out, "cpu_record", cpuRecord);
+    out << ",\n";
+    writeStats(out, "gpu_frame", gpu);
+    out << "\n  },\n"
+        << "  \"gpu_scopes\": [";
+    for (size_t i = 0; i < scopeStats.size(); ++i) {
+        const ScopeStats& s = scopeStats[i];
+        out << (i ? ",\n" : "\n")
+            << "    { \"name\": \"" << jsonEscape(s.label) << "\", \"depth\": " << s.depth
+            << ", \"mean_ms\": " << (s.count ? s.sumMs / s.count : 0.0)
+            << ", \"max_ms\": " << s.maxMs << ", \"samples\": " << s.count << " }";
+    }
+    out << (scopeStats.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    return out.str();
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include "GpuProfiler.h"
+#include "DrawList.h"
+
+// --- Benchmark: deterministic camera path + frame time report (--bench <scenario>) ---
+
+// Scene layout for a benchmark run. "default" is the interactive scene (grid + 3 pyramids);
+// the others scale the same objects up to stress per-object CPU and GPU costs.
+struct BenchScenario {
+    std::string name;
+    int gridLines = 20;        // GridObject size
+    float gridSpacing = 0.5f;
+    int pyramidCols = 3;       // pyramids on an X/Z lattice centred on the origin
+    int pyramidRows = 1;
+    float pyramidSpacing = 1.5f;
+    bool instanced = false;    // pyramids as instances of one InstancedMeshObject (one draw call)
+};
+
+bool FindBenchScenario(const std::string& name, BenchScenario& out);
+std::string ListBenchScenarios(); // comma separated, for usage text
+
+struct CameraPose {
+    float x, y, z;
+    float yaw, pitch;
+};
+
+// Closed Catmull-Rom spline through fixed camera keys. Sampled by frame number (not wall
+// time), so every run renders exactly the same sequence of images.
+class CameraPath {
+public:
+    explicit CameraPath(float radius);
+    CameraPose sample(uint64_t frame) const;
+private:
+    struct Key { float x, y, z; };
+    std::vector<Key> keys;
+    uint32_t framesPerKey = 90;
+};
+
+// Per-frame timings collected after the warm-up phase
+struct BenchSample {
+    double cpuFrameMs = 0.0; // frame-to-frame wall time
+    double cpuWaitMs = 0.0;  // part of it spent blocked on the GPU (FrameScheduler)
+    double cpuRecordMs = 0.0; // part of it spent recording the command buffer(s)
+    double gpuMs = -1.0;     // render command buffer GPU time; < 0 until the timestamps arrive
+    uint64_t heapAllocations = 0; // operator new/ImGui allocations during the frame (AllocationCounter)
+};
+
+// Extra context written into the report header so runs are only compared like-for-like
+// Attachment memory at one resolution (see RenderTargetAllocator)
+struct BenchRenderTargets {
+    uint32_t width = 0, height = 0;
+    uint64_t committedBytes = 0, unaliasedBytes = 0, lazyBytes = 0;
+};
+
+struct BenchMemoryCategory {
+    std::string name;
+    uint64_t bytes = 0;
+    uint32_t allocations = 0;
+};
+
+struct BenchMemoryHeap {
+    uint64_t size = 0, budget = 0, usage = 0; // usage is 0 without VK_EXT_memory_budget
+    bool deviceLocal = false;
+};
+
+struct BenchReportInfo {
+    std::string deviceName;
+    uint32_t width = 0, height = 0;
+    std::string presentMode; // "headless" when there is no swapchain
+    bool validation = false;
+    size_t objectCount = 0;
+    uint32_t instanceCount = 0; // InstancedMeshObject instances (0 = scene not instanced)
+    bool gpuCulling = false;    // culled on the GPU; then the last collected frame's counts:
+    uint32_t cullSubmitted = 0; // instances
+    uint32_t cullDrawn = 0;
+    uint32_t cullObjectsSubmitted = 0; // plain objects (bindless path)
+    uint32_t cullObjectsDrawn = 0;
+    bool drawSort = false;      // state-sorted draw list; binds are the last recorded frame's
+    DrawBindStats binds;
+    uint32_t recordThreads = 0; // 0 = single primary command buffer recorded inline
+    std::string drawPath;       // DrawPathName: "bindless" or "ubo"
+    std::vector<BenchRenderTargets> renderTargets; // one entry per resolution used
+    // Memory at the end of the run
+    std::vector<BenchMemoryCategory> memoryCategories;
+    std::vector<BenchMemoryHeap> memoryHeaps;
+    bool memoryBudgetExtension = false;
+    uint64_t memoryPeakBytes = 0;
+    double memoryFragmentation = 0.0;
+    uint32_t memorySparseBlocks = 0;
+    uint64_t defragMovedBytes = 0;
+    // Per-frame CPU arenas (FrameArena), largest of all frame contexts
+    uint64_t frameArenaHighWater = 0;
+    uint64_t frameArenaOverflows = 0;
+};
+
+// Writes report JSON to path, or stdout when path is empty
+void WriteBenchReport(const std::string& path, const std::string& json);
+
+class Benchmark {
+public:
+    Benchmark(const BenchScenario& scenario, uint32_t warmupFrames, uint32_t recordFrames);
+
+    // Camera pose for the frame about to be recorded
+    CameraPose getCameraPose() const { return path.sample(frameIndex); }
+    // Call once per submitted frame; returns the benchmark frame index of that frame
+    uint64_t endFrame(double cpuFrameMs, double cpuWaitMs, double cpuRecordMs, uint64_t heapAllocations);
+    // GPU time arrives a few frames late (once the frame's timestamps are available)
+    void setGpuTime(uint64_t benchFrame, double gpuMs);
+    // Per-scope GPU times of a frame (GpuProfiler results), aggregated over recorded frames
+    void addGpuScopes(uint64_t benchFrame, const std::vector<GpuScopeResult>& scopes);
+
+    bool isFinished() const { return frameIndex >= warmupFrames + recordFrames; }
+    const BenchScenario& getScenario() const { return scenario; }
+
+    // JSON report of the recorded frames (one object; sweeps collect several into "runs")
+    std::string buildReport(const BenchReportInfo& info) const;
+    void writeReport(const std::string& path, const BenchReportInfo& info) const { WriteBenchReport(path, buildReport(info)); }
+private:
+    BenchScenario scenario;
+    CameraPath path;
+    uint32_t warmupFrames;
+    uint32_t recordFrames;
+    uint64_t frameIndex = 0;
+    std::vector<BenchSample> samples;
+    struct ScopeStats {
+        std::string label;
+        uint32_t depth = 0;
+        double sumMs = 0.0, maxMs = 0.0;
+        uint64_t count = 0;
+    };
+    // Scope names are string literals, so lookups compare them without building strings
+    // (aggregating a frame must not allocate; only a scope's first sighting does)
+    struct ScopeKey {
+        uint32_t depth;
+        const char* name;
+        int32_t index;
+        bool operator<(const ScopeKey& o) const;
+    };
+    std::vector<ScopeStats> scopeStats;           // first-seen (pre-)order
+    std::map<ScopeKey, size_t> scopeLookup;       // -> scopeStats index
+    bool isRecorded(uint64_t benchFrame) const { return benchFrame >= warmupFrames && benchFrame - warmupFrames < samples.size(); }
+};
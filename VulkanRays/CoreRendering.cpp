@@ -3,6 +3,9 @@
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
+#include <string>
+#include <cstdio>
+#include "MathUtils.h"
 
 // --- CoreRendering: Depth Buffering ---
 VkFormat FindSupportedDepthFormat(VkPhysicalDevice physicalDevice) {
@@ -20,90 +23,68 @@ VkFormat FindSupportedDepthFormat(VkPhysicalDevice physicalDevice) {
     throw std::runtime_error("Failed to find supported depth format");
 }
 
-void CreateDepthResources(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat format, DepthResources& out, VkImageUsageFlags usage) {
+void AddDepthTarget(RenderTargetAllocator& targets, VkFormat format, DepthResources& out) {
+    RenderTargetDesc desc;
+    desc.name = "depth";
+    desc.format = format;
+    desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    desc.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    desc.transient = true; // loadOp CLEAR, storeOp DONT_CARE
     out.format = format;
-    VkImageCreateInfo imageInfo{};
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = extent.width;
-    imageInfo.extent.height = extent.height;
-    imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
-    imageInfo.format = format;
-    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = usage;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    if (vkCreateImage(device, &imageInfo, nullptr, &out.image) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create depth image");
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(device, out.image, &memRequirements);
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    // Find memory type (helper not included here)
-    // allocInfo.memoryTypeIndex = FindMemoryType(...);
-    // For now, set to 0 (user must set correctly)
-    allocInfo.memoryTypeIndex = 0;
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &out.memory) != VK_SUCCESS)
-        throw std::runtime_error("Failed to allocate depth image memory");
-    vkBindImageMemory(device, out.image, out.memory, 0);
-    VkImageViewCreateInfo viewInfo{};
-    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = out.image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = format;
-    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
-    if (vkCreateImageView(device, &viewInfo, nullptr, &out.view) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create depth image view");
-}
-
-void DestroyDepthResources(VkDevice device, DepthResources& res) {
-    if (res.view) vkDestroyImageView(device, res.view, nullptr);
-    if (res.image) vkDestroyImage(device, res.image, nullptr);
-    if (res.memory) vkFreeMemory(device, res.memory, nullptr);
-    res.view = VK_NULL_HANDLE;
-    res.image = VK_NULL_HANDLE;
-    res.memory = VK_NULL_HANDLE;
+    out.target = targets.add(desc);
 }
 
 // --- CoreRendering: Double/Triple Buffering ---
-void CreateSyncObjects(VkDevice device, int maxFramesInFlight, SyncObjects& sync) {
-    sync.imageAvailableSemaphores.resize(maxFramesInFlight);
-    sync.renderFinishedSemaphores.resize(maxFramesInFlight);
-    sync.inFlightFences.resize(maxFramesInFlight);
+void CreateFrameContext(VulkanDevice& device, VkDeviceSize uniformBytes, size_t arenaBytes, uint32_t secondaryCount, FrameContext& out) {
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device.getGraphicsQueueFamily();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    if (vkCreateCommandPool(device.getDevice(), &poolInfo, nullptr, &out.commandPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create command pool");
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = out.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &out.commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate command buffers");
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &out.uiCommandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate command buffers");
+    out.secondaryPools.resize(secondaryCount, VK_NULL_HANDLE);
+    out.secondaryCommandBuffers.resize(secondaryCount, VK_NULL_HANDLE);
+    out.executeList.resize(secondaryCount + 1, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i < secondaryCount; ++i) {
+        if (vkCreateCommandPool(device.getDevice(), &poolInfo, nullptr, &out.secondaryPools[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create command pool");
+        allocInfo.commandPool = out.secondaryPools[i];
+        if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &out.secondaryCommandBuffers[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate command buffers");
+    }
     VkSemaphoreCreateInfo semInfo{};
     semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    for (int i = 0; i < maxFramesInFlight; ++i) {
-        if (vkCreateSemaphore(device, &semInfo, nullptr, &sync.imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device, &semInfo, nullptr, &sync.renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(device, &fenceInfo, nullptr, &sync.inFlightFences[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create sync objects");
-        }
-    }
+    if (vkCreateSemaphore(device.getDevice(), &semInfo, nullptr, &out.imageAvailable) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create sync objects");
+    out.uniforms = new UniformRing(device, uniformBytes);
+    out.arena = new FrameArena(arenaBytes);
 }
-void DestroySyncObjects(VkDevice device, SyncObjects& sync) {
-    for (auto s : sync.imageAvailableSemaphores) if (s) vkDestroySemaphore(device, s, nullptr);
-    for (auto s : sync.renderFinishedSemaphores) if (s) vkDestroySemaphore(device, s, nullptr);
-    for (auto f : sync.inFlightFences) if (f) vkDestroyFence(device, f, nullptr);
-    sync.imageAvailableSemaphores.clear();
-    sync.renderFinishedSemaphores.clear();
-    sync.inFlightFences.clear();
+
+void DestroyFrameContext(VkDevice device, FrameContext& ctx) {
+    // Command buffers are freed together with their pool
+    if (ctx.commandPool) vkDestroyCommandPool(device, ctx.commandPool, nullptr);
+    for (VkCommandPool pool : ctx.secondaryPools)
+        if (pool) vkDestroyCommandPool(device, pool, nullptr);
+    if (ctx.imageAvailable) vkDestroySemaphore(device, ctx.imageAvailable, nullptr);
+    delete ctx.uniforms; // descriptorSet goes with its pool
+    delete ctx.arena;
+    ctx = FrameContext{};
 }
 
 // --- CoreRendering: Descriptor Management ---
-void CreateUBODescriptorPool(VkDevice device, uint32_t numSets, VkDescriptorPool& pool) {
+void CreateUBODescriptorPool(VkDevice device, uint32_t numSets, VkDescriptorPool& pool, VkDescriptorType type) {
     VkDescriptorPoolSize poolSize{};
-    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSize.type = type;
     poolSize.descriptorCount = numSets;
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -132,115 +113,80 @@ void DestroyDescriptorPools(VkDevice device, DescriptorPools& pools) {
     pools.samplerPool = VK_NULL_HANDLE;
 }
 
-// --- CoreRendering: Swapchain Recreation ---
-void RecreateSwapchain(
-    VkDevice device,
-    VkPhysicalDevice physicalDevice,
-    VkSurfaceKHR surface,
-    VkInstance instance,
-    VkExtent2D& windowExtent,
-    SwapchainResources& swapchainRes,
-    std::vector<VkFramebuffer>& framebuffers,
-    VkRenderPass renderPass,
-    DepthResources& depthRes
-) {
-    // Destroy old image views
-    for (auto view : swapchainRes.imageViews) {
-        if (view) vkDestroyImageView(device, view, nullptr);
-    }
-    swapchainRes.imageViews.clear();
-    // Destroy old swapchain
-    if (swapchainRes.swapchain) {
-        vkDestroySwapchainKHR(device, swapchainRes.swapchain, nullptr);
-        swapchainRes.swapchain = VK_NULL_HANDLE;
+// --- CoreRendering: Offscreen Target (headless) ---
+void CreateOffscreenTarget(VulkanDevice& device, RenderTargetAllocator& targets, VkExtent2D extent, VkFormat format, uint32_t imageCount, OffscreenTarget& out) {
+    out.format = format;
+    out.extent = extent;
+    out.targets.resize(imageCount);
+    out.images.resize(imageCount, VK_NULL_HANDLE);
+    out.imageViews.resize(imageCount, VK_NULL_HANDLE);
+    out.readbackBuffers.resize(imageCount);
+    for (uint32_t i = 0; i < imageCount; ++i) {
+        // Rendered in pass 0 and copied out in pass 1; frames in flight each have their own,
+        // and the readback must survive, so these never alias
+        RenderTargetDesc desc;
+        desc.name = "offscreen color";
+        desc.format = format;
+        desc.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        desc.firstPass = 0;
+        desc.lastPass = UINT32_MAX;
+        out.targets[i] = targets.add(desc);
+        out.readbackBuffers[i] = new VulkanBuffer(
+            device,
+            device.getPhysicalDevice(),
+            (VkDeviceSize)extent.width * extent.height * 4,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryCategory::Staging
+        );
     }
-    // Query surface capabilities
-    VkSurfaceCapabilitiesKHR caps;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps);
-    uint32_t formatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
-    std::vector<VkSurfaceFormatKHR> formats(formatCount);
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, formats.data());
-    VkSurfaceFormatKHR surfaceFormat = formats[0];
-    for (const auto& f : formats) {
-        if (f.format == VK_FORMAT_B8G8R8A8_SRGB && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-            surfaceFormat = f;
-            break;
-        }
+}
+
+void DestroyOffscreenTarget(VkDevice device, OffscreenTarget& target) {
+    // Images belong to the RenderTargetAllocator
+    for (auto buffer : target.readbackBuffers) {
+        if (!buffer) continue;
+        buffer->destroy();
+        delete buffer;
     }
-    uint32_t presentModeCount;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
-    std::vector<VkPresentModeKHR> presentModes(presentModeCount);
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, presentModes.data());
-    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    for (const auto& pm : presentModes) {
-        if (pm == VK_PRESENT_MODE_MAILBOX_KHR) {
-            presentMode = pm;
-            break;
+    target = OffscreenTarget{};
+}
+
+void RecordOffscreenReadback(VkCommandBuffer cmd, const OffscreenTarget& target, uint32_t index) {
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;   // tightly packed
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = { target.extent.width, target.extent.height, 1 };
+    vkCmdCopyImageToBuffer(cmd, target.images[index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           target.readbackBuffers[index]->getBuffer(), 1, &region);
+    // Make the copy visible to the host once the frame's timeline value is reached
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void WriteReadbackPPM(const char* path, const unsigned char* rgba, VkExtent2D extent) {
+    FILE* f = std::fopen(path, "wb");
+    if (!f) throw std::runtime_error(std::string("Failed to open ") + path + " for writing");
+    std::fprintf(f, "P6\n%u %u\n255\n", extent.width, extent.height);
+    std::vector<unsigned char> row(extent.width * 3);
+    for (uint32_t y = 0; y < extent.height; ++y) {
+        const unsigned char* src = rgba + (size_t)y * extent.width * 4;
+        for (uint32_t x = 0; x < extent.width; ++x) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
         }
+        std::fwrite(row.data(), 1, row.size(), f);
     }
-    VkExtent2D ext = windowExtent;
-    ext.width = std::max(caps.minImageExtent.width, std::min(caps.maxImageExtent.width, ext.width));
-    ext.height = std::max(caps.minImageExtent.height, std::min(caps.maxImageExtent.height, ext.height));
-    uint32_t imageCount = caps.minImageCount + 1;
-    if (caps.maxImageCount > 0 && imageCount > caps.maxImageCount)
-        imageCount = caps.maxImageCount;
-    VkSwapchainCreateInfoKHR createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    createInfo.surface = surface;
-    createInfo.minImageCount = imageCount;
-    createInfo.imageFormat = surfaceFormat.format;
-    createInfo.imageColorSpace = surfaceFormat.colorSpace;
-    createInfo.imageExtent = ext;
-    createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    createInfo.preTransform = caps.currentTransform;
-    createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    createInfo.presentMode = presentMode;
-    createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
-    if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapchainRes.swapchain) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create swapchain");
-    vkGetSwapchainImagesKHR(device, swapchainRes.swapchain, &imageCount, nullptr);
-    swapchainRes.images.resize(imageCount);
-    vkGetSwapchainImagesKHR(device, swapchainRes.swapchain, &imageCount, swapchainRes.images.data());
-    swapchainRes.imageFormat = surfaceFormat.format;
-    swapchainRes.extent = ext;
-    // Create image views
-    swapchainRes.imageViews.resize(swapchainRes.images.size());
-    for (size_t i = 0; i < swapchainRes.images.size(); ++i) {
-        VkImageViewCreateInfo viewInfo{};
-        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        viewInfo.image = swapchainRes.images[i];
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format = swapchainRes.imageFormat;
-        viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
-                                VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
-        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        viewInfo.subresourceRange.baseMipLevel = 0;
-        viewInfo.subresourceRange.levelCount = 1;
-        viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount = 1;
-        if (vkCreateImageView(device, &viewInfo, nullptr, &swapchainRes.imageViews[i]) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create image view");
-    }
-    // Recreate depth resources
-    depthRes.format = FindSupportedDepthFormat(physicalDevice);
-    CreateDepthResources(device, physicalDevice, ext, depthRes.format, depthRes, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
-    // Recreate framebuffers
-    framebuffers.resize(swapchainRes.imageViews.size());
-    for (size_t i = 0; i < swapchainRes.imageViews.size(); ++i) {
-        VkImageView attachments[] = { swapchainRes.imageViews[i], depthRes.view };
-        VkFramebufferCreateInfo fbInfo{};
-        fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        fbInfo.renderPass = renderPass;
-        fbInfo.attachmentCount = 2;
-        fbInfo.pAttachments = attachments;
-        fbInfo.width = ext.width;
-        fbInfo.height = ext.height;
-        fbInfo.layers = 1;
-        if (vkCreateFramebuffer(device, &fbInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create framebuffer");
-    }
+    std::fclose(f);
 }
@@ -2,49 +2,75 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <cstdint>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "UniformRing.h"
+#include "FrameArena.h"
+#include "RenderTargetAllocator.h"
 
 // --- CoreRendering: Depth Buffering ---
+// The image itself is a transient render target (RenderTargetAllocator); image/view are
+// refreshed from it whenever the targets are rebuilt
 struct DepthResources {
     VkImage image = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
     VkImageView view = VK_NULL_HANDLE;
     VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t target = UINT32_MAX;
 };
 
-void CreateDepthResources(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat format, DepthResources& out, VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
-void DestroyDepthResources(VkDevice device, DepthResources& res);
+// Declares the depth buffer (cleared on load, never stored) with the render-target allocator
+void AddDepthTarget(RenderTargetAllocator& targets, VkFormat format, DepthResources& out);
 VkFormat FindSupportedDepthFormat(VkPhysicalDevice physicalDevice);
 
-// --- CoreRendering: Swapchain Recreation ---
-struct SwapchainResources {
-    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+// --- CoreRendering: Offscreen Target (headless) ---
+// Surface-less stand-in for the swapchain: one color image per frame in flight (so frames
+// in flight never write the same image) plus a host-visible readback buffer for each.
+// The images are render targets; images/imageViews mirror them after each build.
+struct OffscreenTarget {
+    std::vector<uint32_t> targets;
     std::vector<VkImage> images;
     std::vector<VkImageView> imageViews;
-    VkFormat imageFormat = VK_FORMAT_UNDEFINED;
+    std::vector<VulkanBuffer*> readbackBuffers;
+    VkFormat format = VK_FORMAT_UNDEFINED;
     VkExtent2D extent = {0,0};
 };
 
-void RecreateSwapchain(
-    VkDevice device,
-    VkPhysicalDevice physicalDevice,
-    VkSurfaceKHR surface,
-    VkInstance instance,
-    VkExtent2D& windowExtent,
-    SwapchainResources& swapchainRes,
-    std::vector<VkFramebuffer>& framebuffers,
-    VkRenderPass renderPass,
-    DepthResources& depthRes
-);
+// Declares the color targets and creates the readback buffers; the images exist after targets.build()
+void CreateOffscreenTarget(VulkanDevice& device, RenderTargetAllocator& targets, VkExtent2D extent, VkFormat format, uint32_t imageCount, OffscreenTarget& out);
+void DestroyOffscreenTarget(VkDevice device, OffscreenTarget& target);
+// Records a copy of target.images[index] (in TRANSFER_SRC_OPTIMAL) into its readback buffer
+void RecordOffscreenReadback(VkCommandBuffer cmd, const OffscreenTarget& target, uint32_t index);
+// Writes an RGBA8 readback as binary PPM (alpha dropped)
+void WriteReadbackPPM(const char* path, const unsigned char* rgba, VkExtent2D extent);
 
 // --- CoreRendering: Double/Triple Buffering ---
-struct SyncObjects {
-    std::vector<VkSemaphore> imageAvailableSemaphores;
-    std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
+// Frame pacing lives in FrameScheduler (timeline semaphore). Everything the CPU writes
+// while recording a frame lives in a FrameContext, one per frame in flight, so a context
+// is only touched again once the GPU has retired the frame that last used it.
+struct FrameContext {
+    VkCommandPool commandPool = VK_NULL_HANDLE;      // reset once per frame with vkResetCommandPool
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkSemaphore imageAvailable = VK_NULL_HANDLE;     // swapchain acquire for this frame
+    UniformRing* uniforms = nullptr;                 // this frame's MVPs, bump-allocated while recording
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;  // dynamic UBO over uniforms, shared by all draws
+    FrameArena* arena = nullptr;                     // transient CPU data, reset when recording starts
+    uint32_t slot = 0;                               // index among the frames in flight (TransformBuffer slot)
+    uint64_t benchFrame = 0;                         // benchmark frame recorded with this context
+    // Multithreaded recording: one pool + secondary buffer per recording thread (a pool
+    // must only be used by one thread), plus a secondary for ImGui from commandPool
+    std::vector<VkCommandPool> secondaryPools;
+    std::vector<VkCommandBuffer> secondaryCommandBuffers;
+    VkCommandBuffer uiCommandBuffer = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> executeList;        // scratch for vkCmdExecuteCommands
 };
 
-void CreateSyncObjects(VkDevice device, int maxFramesInFlight, SyncObjects& sync);
-void DestroySyncObjects(VkDevice device, SyncObjects& sync);
+// uniformBytes: capacity of the frame's uniform ring, arenaBytes: initial FrameArena size
+void CreateFrameContext(VulkanDevice& device, VkDeviceSize uniformBytes, size_t arenaBytes, uint32_t secondaryCount, FrameContext& out);
+void DestroyFrameContext(VkDevice device, FrameContext& ctx);
+
+inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment ? (value + alignment - 1) / alignment * alignment : value;
+}
 
 // --- CoreRendering: Descriptor Management ---
 struct DescriptorPools {
@@ -52,6 +78,6 @@ struct DescriptorPools {
     VkDescriptorPool samplerPool = VK_NULL_HANDLE;
 };
 
-void CreateUBODescriptorPool(VkDevice device, uint32_t numSets, VkDescriptorPool& pool);
+void CreateUBODescriptorPool(VkDevice device, uint32_t numSets, VkDescriptorPool& pool, VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 void CreateSamplerDescriptorPool(VkDevice device, uint32_t numSets, VkDescriptorPool& pool);
 void DestroyDescriptorPools(VkDevice device, DescriptorPools& pools);
@@ -0,0 +1,82 @@
+#include "CpuTrace.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace CpuTrace {
+std::atomic<bool> enabled{true};
+
+namespace {
+// Registry of all thread rings; only touched when a thread records its first zone and when
+// dumping. Rings are never freed so a dump can still read threads that have exited.
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>>& registry() {
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    return buffers;
+}
+
+ThreadBuffer* registerThread() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto& buffers = registry();
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    buffers.back()->threadId = (uint32_t)buffers.size();
+    return buffers.back().get();
+}
+
+void writeJsonString(std::ostream& out, const char* s) {
+    out << '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out << '\\';
+        out << *s;
+    }
+    out << '"';
+}
+} // namespace
+
+ThreadBuffer& GetThreadBuffer() {
+    thread_local ThreadBuffer* buffer = registerThread();
+    return *buffer;
+}
+
+bool DumpChromeTrace(const std::string& path, double seconds) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << std::fixed << std::setprecision(3); // ts is in microseconds
+    uint64_t cutoff = NowNs() - (uint64_t)(seconds * 1e9);
+    std::vector<Event> events;
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& buffer : registry()) {
+        // Copy the live part of the ring, then drop anything the writer lapped meanwhile
+        uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+        uint64_t begin = end > ThreadBuffer::Capacity ? end - ThreadBuffer::Capacity : 0;
+        events.clear();
+        for (uint64_t i = begin; i < end; ++i)
+            events.push_back(buffer->events[i & (ThreadBuffer::Capacity - 1)]);
+        uint64_t endAfter = buffer->writeIndex.load(std::memory_order_acquire);
+        size_t skip = endAfter > begin + ThreadBuffer::Capacity ? (size_t)(endAfter - ThreadBuffer::Capacity - begin) : 0;
+        // Zones whose begin fell out of the window/ring would show up as unmatched ends
+        int depth = 0;
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event& e = events[i];
+            if (e.timeNs < cutoff) continue;
+            if (e.phase == 'E') {
+                if (depth == 0) continue;
+                --depth;
+            } else {
+                ++depth;
+            }
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(out, e.name);
+            out << ",\"ph\":\"" << e.phase << "\",\"ts\":" << (e.timeNs / 1000.0)
+                << ",\"pid\":1,\"tid\":" << buffer->threadId << "}";
+            first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return true;
+}
+}
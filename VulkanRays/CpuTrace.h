@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <string>
+
+// --- CpuTrace: scoped CPU zones exported as Chrome trace_event JSON ---
+// TRACE_ZONE("name") writes a begin record now and an end record at scope exit into a
+// fixed-size ring owned by the calling thread. Recording is a clock read plus two stores
+// (no locks, no allocation), so zones can stay enabled in release builds. Old records are
+// overwritten; DumpChromeTrace writes whatever is left of the last N seconds and can be
+// opened in chrome://tracing or ui.perfetto.dev.
+// Names must be string literals (only the pointer is stored).
+// Define VULKANRAYS_DISABLE_TRACING to compile all zones out.
+
+namespace CpuTrace {
+    struct Event {
+        const char* name;
+        uint64_t timeNs;  // steady_clock
+        char phase;       // 'B' or 'E'
+    };
+
+    // Per-thread single-producer ring. Only the owning thread writes; readers copy and then
+    // re-check writeIndex to drop slots that were overwritten during the copy.
+    struct ThreadBuffer {
+        static constexpr uint32_t Capacity = 1u << 16; // events, power of two
+        Event events[Capacity];
+        std::atomic<uint64_t> writeIndex{0};
+        uint32_t threadId = 0;
+    };
+
+    extern std::atomic<bool> enabled;
+    ThreadBuffer& GetThreadBuffer(); // registers the calling thread on first use
+
+    inline uint64_t NowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline void Record(const char* name, char phase) {
+        ThreadBuffer& buffer = GetThreadBuffer();
+        uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+        Event& e = buffer.events[index & (ThreadBuffer::Capacity - 1)];
+        e.name = name;
+        e.timeNs = NowNs();
+        e.phase = phase;
+        buffer.writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    // Writes the last `seconds` of every thread's ring; returns false if the file can't be opened
+    bool DumpChromeTrace(const std::string& path, double seconds);
+
+    class Zone {
+    public:
+        explicit Zone(const char* name) : name(enabled.load(std::memory_order_relaxed) ? name : nullptr) {
+            if (this->name) Record(this->name, 'B');
+        }
+        ~Zone() { if (name) Record(name, 'E'); }
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    private:
+        const char* name;
+    };
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#ifdef VULKANRAYS_DISABLE_TRACING
+#define TRACE_ZONE(name) ((void)0)
+#else
+#define TRACE_ZONE(name) CpuTrace::Zone TRACE_CONCAT(traceZone_, __LINE__)(name)
+#endif
@@ -0,0 +1,79 @@
+#include "Defragmenter.h"
+#include "CpuTrace.h"
+
+Defragmenter::Defragmenter(VulkanDevice& device, DeletionQueue& retired, const UploadService& uploads, double maxOccupancy)
+    : device(device), retired(retired), uploads(uploads), maxOccupancy(maxOccupancy) {}
+
+void Defragmenter::step(VkCommandBuffer cmd, VkDeviceSize budget) {
+    stats.frameBytes = 0;
+    stats.frameMoves = 0;
+    if (budget == 0) return;
+    if (backoff) {
+        --backoff;
+        return;
+    }
+    // Sources must hold their final contents
+    if (!uploads.isComplete(uploads.getLatestValue())) return;
+    TRACE_ZONE("Defragmenter::step");
+    uint32_t block = device.getAllocator().findDefragBlock(maxOccupancy, owners);
+    if (block == MemoryAllocator::NONE) {
+        backoff = IDLE_BACKOFF_FRAMES;
+        return;
+    }
+    // Instance buffers and the culler's count buffer are written on the GPU every frame (copies,
+    // compute): the previous frame's writes have to land before a move reads the old copy
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+    size_t moved = 0;
+    for (void* owner : owners) {
+        VulkanBuffer& buffer = *static_cast<VulkanBuffer*>(owner);
+        if (stats.frameMoves && stats.frameBytes + buffer.getSize() > budget) break;
+        if (!move(cmd, buffer, block)) {
+            backoff = STALLED_BACKOFF_FRAMES;
+            break;
+        }
+        ++moved;
+    }
+    if (moved == owners.size()) ++stats.blocksEvacuated;
+    if (!stats.frameMoves) return;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+bool Defragmenter::move(VkCommandBuffer cmd, VulkanBuffer& buffer, uint32_t avoidBlock) {
+    MemoryAllocator& allocator = device.getAllocator();
+    VkBuffer moved = VulkanBuffer::createHandle(device, buffer.size, buffer.usage, buffer.shareAcrossQueues);
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device.getDevice(), moved, &requirements);
+    MemoryAllocation target = allocator.allocateForMove(buffer.allocation, requirements, avoidBlock);
+    if (target.region == MemoryAllocator::NONE) {
+        vkDestroyBuffer(device.getDevice(), moved, nullptr);
+        return false;
+    }
+    vkBindBufferMemory(device.getDevice(), moved, target.memory, target.offset);
+    VkBufferCopy region{ 0, 0, buffer.size };
+    vkCmdCopyBuffer(cmd, buffer.buffer, moved, 1, &region);
+    // The old copy stays readable for frames in flight and is no longer a move candidate
+    allocator.markMoved(buffer.allocation);
+    allocator.setOwner(target, &buffer);
+    VkDevice vkDevice = device.getDevice();
+    VkBuffer oldBuffer = buffer.buffer;
+    MemoryAllocation oldAllocation = buffer.allocation;
+    retired.release([vkDevice, &allocator, oldBuffer, oldAllocation]() mutable {
+        vkDestroyBuffer(vkDevice, oldBuffer, nullptr);
+        allocator.free(oldAllocation);
+    });
+    buffer.buffer = moved;
+    buffer.allocation = target;
+    stats.frameBytes += buffer.size;
+    ++stats.frameMoves;
+    stats.totalBytes += buffer.size;
+    ++stats.totalMoves;
+    return true;
+}
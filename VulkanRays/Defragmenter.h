@@ -0,0 +1,52 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "DeletionQueue.h"
+#include "UploadService.h"
+
+// --- Defragmenter: incremental compaction of device-local buffer memory ---
+// Each step() picks the least occupied shared block (MemoryAllocator::findDefragBlock) and
+// moves movable buffers out of it into the free space of the pool's other blocks, up to a
+// byte budget per frame. A move creates a new VkBuffer, records a GPU copy into the frame's
+// command buffer and swaps the VulkanBuffer's handle and allocation in place, so owners
+// pick up the new binding the next time they record. The old copy goes through the
+// DeletionQueue (frames in flight still read it); once the last one is freed the empty
+// block is released. Nothing moves while uploads are outstanding, so copies never race
+// the transfer queue; a barrier ahead of the moves orders them after the graphics queue's
+// own GPU writes of earlier frames (instance updates, culling counts).
+struct DefragStats {
+    VkDeviceSize frameBytes = 0;   // moved by the last step()
+    uint32_t frameMoves = 0;
+    VkDeviceSize totalBytes = 0;
+    uint64_t totalMoves = 0;
+    uint32_t blocksEvacuated = 0;  // blocks left without live buffers
+};
+
+class Defragmenter {
+public:
+    // maxOccupancy: blocks more than this share used are left alone
+    Defragmenter(VulkanDevice& device, DeletionQueue& retired, const UploadService& uploads, double maxOccupancy = 0.5);
+
+    // Records moves (outside a render pass) between a barrier that waits for earlier transfer
+    // and compute writes and one that makes the moves visible to vertex input. At least one buffer moves per call even if it is bigger than budget; 0 = off.
+    void step(VkCommandBuffer cmd, VkDeviceSize budget);
+    const DefragStats& getStats() const { return stats; }
+
+    Defragmenter(const Defragmenter&) = delete;
+    Defragmenter& operator=(const Defragmenter&) = delete;
+private:
+    static constexpr uint32_t IDLE_BACKOFF_FRAMES = 30;    // nothing to do: look again later
+    static constexpr uint32_t STALLED_BACKOFF_FRAMES = 240; // no room elsewhere for a move
+    VulkanDevice& device;
+    DeletionQueue& retired;
+    const UploadService& uploads;
+    double maxOccupancy;
+    std::vector<void*> owners;     // scratch for findDefragBlock
+    uint32_t backoff = 0;
+    DefragStats stats;
+
+    bool move(VkCommandBuffer cmd, VulkanBuffer& buffer, uint32_t avoidBlock);
+};
@@ -0,0 +1,92 @@
+#include "DeletionQueue.h"
+#include <algorithm>
+#include "CpuTrace.h"
+
+DeletionQueue::DeletionQueue(VulkanDevice& device, const FrameScheduler& frames, const UploadService& uploads, VkDeviceSize poolLimit)
+    : device(device), frames(frames), uploads(uploads), poolLimit(poolLimit) {}
+
+DeletionQueue::~DeletionQueue() {
+    for (Entry& entry : pending) {
+        if (entry.destroy) entry.destroy();
+        entry.buffer.reset();
+    }
+    pool.clear();
+}
+
+std::unique_ptr<VulkanBuffer> DeletionQueue::acquireBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                                                           MemoryCategory category, bool shareAcrossQueues) {
+    // Best fit among compatible pooled buffers, wasting at most half of the one handed out
+    size_t best = pool.size();
+    for (size_t i = 0; i < pool.size(); ++i) {
+        const VulkanBuffer& b = *pool[i];
+        if (b.getUsage() != usage || b.getMemoryProperties() != properties || b.getCategory() != category ||
+            b.isSharedAcrossQueues() != shareAcrossQueues || b.getSize() < size || b.getSize() > size * 2)
+            continue;
+        if (best == pool.size() || b.getSize() < pool[best]->getSize()) best = i;
+    }
+    if (best == pool.size())
+        return std::make_unique<VulkanBuffer>(device, device.getPhysicalDevice(), size, usage, properties, category, shareAcrossQueues);
+    std::unique_ptr<VulkanBuffer> buffer = std::move(pool[best]);
+    pool.erase(pool.begin() + best);
+    --stats.pooledCount;
+    stats.pooledBytes -= buffer->getSize();
+    ++stats.recycled;
+    return buffer;
+}
+
+void DeletionQueue::release(std::unique_ptr<VulkanBuffer> buffer, bool recycle) {
+    if (!buffer) return;
+    ++stats.pendingCount;
+    stats.pendingBytes += buffer->getSize();
+    Entry entry{ frames.getCurrentTicket(), uploads.getLatestValue() };
+    entry.buffer = std::move(buffer);
+    entry.recycle = recycle;
+    pending.push_back(std::move(entry));
+}
+
+void DeletionQueue::release(std::function<void()> destroy) {
+    ++stats.pendingCount;
+    Entry entry{ frames.getCurrentTicket(), uploads.getLatestValue() };
+    entry.destroy = std::move(destroy);
+    pending.push_back(std::move(entry));
+}
+
+void DeletionQueue::collect() {
+    if (pending.empty()) return;
+    TRACE_ZONE("DeletionQueue::collect");
+    uint64_t completedFrame = frames.getCompletedTicket();
+    while (!pending.empty() && pending.front().frame <= completedFrame && uploads.isComplete(pending.front().upload)) {
+        retire(pending.front());
+        pending.pop_front();
+    }
+    // Keep the pool bounded: drop the buffers that have been sitting there longest
+    size_t trimmed = 0;
+    while (trimmed < pool.size() && stats.pooledBytes > poolLimit) {
+        stats.pooledBytes -= pool[trimmed]->getSize();
+        --stats.pooledCount;
+        destroyBuffer(pool[trimmed++]);
+    }
+    pool.erase(pool.begin(), pool.begin() + trimmed);
+}
+
+void DeletionQueue::retire(Entry& entry) {
+    --stats.pendingCount;
+    if (entry.destroy) {
+        entry.destroy();
+        ++stats.destroyed;
+        return;
+    }
+    stats.pendingBytes -= entry.buffer->getSize();
+    if (!entry.recycle) {
+        destroyBuffer(entry.buffer);
+        return;
+    }
+    ++stats.pooledCount;
+    stats.pooledBytes += entry.buffer->getSize();
+    pool.push_back(std::move(entry.buffer));
+}
+
+void DeletionQueue::destroyBuffer(std::unique_ptr<VulkanBuffer>& buffer) {
+    buffer.reset();
+    ++stats.destroyed;
+}
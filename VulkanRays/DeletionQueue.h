@@ -0,0 +1,67 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "FrameScheduler.h"
+#include "UploadService.h"
+
+// --- DeletionQueue: deferred destruction keyed on frame completion ---
+// Whatever is released while frame N is the newest frame begun (FrameScheduler ticket)
+// stays alive until the frame timeline reaches N and every upload batch queued at release
+// time has completed, so objects can be removed mid-session without vkDeviceWaitIdle.
+// Retired buffers go to a free pool rather than being destroyed: acquireBuffer() reuses a
+// pooled buffer with the same usage, memory properties, category and sharing whose size is
+// within 2x of the request, and only creates a buffer when none fits. The pool is trimmed
+// oldest-first above poolLimit bytes. Main thread only.
+struct DeletionStats {
+    uint32_t pendingCount = 0;     // released, GPU may still use them
+    VkDeviceSize pendingBytes = 0; // buffers only
+    uint32_t pooledCount = 0;
+    VkDeviceSize pooledBytes = 0;
+    uint64_t recycled = 0;         // acquireBuffer() calls served from the pool
+    uint64_t destroyed = 0;
+};
+
+class DeletionQueue {
+public:
+    DeletionQueue(VulkanDevice& device, const FrameScheduler& frames, const UploadService& uploads,
+                  VkDeviceSize poolLimit = 32ull << 20);
+    ~DeletionQueue(); // destroys everything at once; the GPU must be idle by then
+
+    // Same parameters as the VulkanBuffer constructor. A recycled buffer may be larger than size.
+    std::unique_ptr<VulkanBuffer> acquireBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                                                MemoryCategory category = MemoryCategory::Other, bool shareAcrossQueues = false);
+    // recycle = false destroys the buffer once retired instead of pooling it
+    void release(std::unique_ptr<VulkanBuffer> buffer, bool recycle = true);
+    // Anything that isn't a VulkanBuffer: destroy runs once the GPU is done
+    void release(std::function<void()> destroy);
+    // Once per frame, after FrameScheduler::beginFrame
+    void collect();
+    const DeletionStats& getStats() const { return stats; }
+
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+private:
+    struct Entry {
+        uint64_t frame;              // frame ticket that has to complete
+        uint64_t upload;             // upload timeline value that has to complete
+        std::unique_ptr<VulkanBuffer> buffer;
+        bool recycle = false;
+        std::function<void()> destroy;
+    };
+    VulkanDevice& device;
+    const FrameScheduler& frames;
+    const UploadService& uploads;
+    VkDeviceSize poolLimit;
+    std::deque<Entry> pending;       // release order, so keys only grow towards the back
+    std::vector<std::unique_ptr<VulkanBuffer>> pool; // oldest first
+    DeletionStats stats;
+
+    void retire(Entry& entry);
+    void destroyBuffer(std::unique_ptr<VulkanBuffer>& buffer);
+};
@@ -0,0 +1,39 @@
+#include "DrawList.h"
+#include <cstring>
+
+uint64_t MakeDrawKey(uint32_t pipeline, uint32_t mesh, uint32_t material, float viewDepth) {
+    // Positive IEEE floats order like their bit patterns, so the top 24 bits are a depth that
+    // keeps the full exponent range without knowing the far plane
+    uint32_t depthBits = 0;
+    if (viewDepth > 0.0f) {
+        std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+        depthBits >>= 8;
+    }
+    return ((uint64_t)(pipeline & 0xFF) << 56) | ((uint64_t)(mesh & 0xFFFFFF) << 32) |
+           ((uint64_t)(material & 0xFF) << 24) | depthBits;
+}
+
+void SortDrawPackets(DrawPacket* packets, DrawPacket* scratch, size_t count) {
+    if (count < 2) return;
+    // All eight histograms in one pass over the keys
+    uint32_t histograms[8][256] = {};
+    for (size_t i = 0; i < count; ++i)
+        for (int pass = 0; pass < 8; ++pass) ++histograms[pass][(packets[i].key >> (pass * 8)) & 0xFF];
+    DrawPacket* src = packets;
+    DrawPacket* dst = scratch;
+    for (int pass = 0; pass < 8; ++pass) {
+        uint32_t* histogram = histograms[pass];
+        if (histogram[(src[0].key >> (pass * 8)) & 0xFF] == count) continue; // byte never varies
+        uint32_t offset = 0;
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; ++i) dst[histogram[(src[i].key >> (pass * 8)) & 0xFF]++] = src[i];
+        DrawPacket* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != packets) std::memcpy(packets, src, sizeof(DrawPacket) * count);
+}
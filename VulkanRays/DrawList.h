@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// --- Draw list: state-sorted draw packets ---
+// Each frame every object becomes a packet with a 64-bit sort key, most significant state
+// first, so sorting groups draws that share a pipeline, then a mesh:
+//   bits 63-56 pipeline | 55-32 mesh | 31-24 material | 23-0 view depth (front to back)
+// Recording walks the sorted packets and only binds what differs from the previous draw.
+// Packets and the sort's scratch space come from the frame arena.
+struct DrawPacket {
+    uint64_t key = 0;
+    uint32_t object = 0; // index into renderObjects (and the frame's MVPs)
+};
+
+// pipeline: small per-frame id; mesh: anything equal for draws that bind the same buffers
+// (collisions only cost sort quality); material: 0 until there are materials;
+// viewDepth: clip-space w, negative (behind the eye) sorts first
+uint64_t MakeDrawKey(uint32_t pipeline, uint32_t mesh, uint32_t material, float viewDepth);
+// LSD radix sort on the key, 8 bits per pass; passes whose byte is the same for every
+// packet are skipped. Stable. The result ends up in packets; scratch needs count entries.
+void SortDrawPackets(DrawPacket* packets, DrawPacket* scratch, size_t count);
+
+// Binds recorded for one frame; with sorting off every draw binds everything
+struct DrawBindStats {
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+};
@@ -0,0 +1,17 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double stepsPerSecond, uint32_t maxStepsPerFrame)
+    : stepSeconds(1.0 / stepsPerSecond), maxStepsPerFrame(maxStepsPerFrame) {}
+
+uint32_t FixedTimestep::advance(double elapsedSeconds) {
+    accumulator += elapsedSeconds;
+    uint32_t steps = 0;
+    while (accumulator >= stepSeconds && steps < maxStepsPerFrame) {
+        accumulator -= stepSeconds;
+        ++steps;
+    }
+    // Fell behind by more than the cap: drop the backlog (simulation slows down instead)
+    if (accumulator >= stepSeconds) accumulator = 0.0;
+    stepCount += steps;
+    return steps;
+}
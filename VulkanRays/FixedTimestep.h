@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+// --- FixedTimestep: decouples simulation rate from render rate ---
+// Real frame time is accumulated and consumed in fixed steps; the remainder becomes the
+// interpolation factor between the previous and current simulation state when rendering.
+// Steps per frame are capped so a long hitch can't trigger a spiral of catch-up updates.
+class FixedTimestep {
+public:
+    explicit FixedTimestep(double stepsPerSecond = 120.0, uint32_t maxStepsPerFrame = 8);
+
+    // Adds elapsed real time and returns how many simulation steps to run now
+    uint32_t advance(double elapsedSeconds);
+    // Position of the render time between the last two simulation states, in [0, 1)
+    float getAlpha() const { return static_cast<float>(accumulator / stepSeconds); }
+    double getStepSeconds() const { return stepSeconds; }
+    uint64_t getStepCount() const { return stepCount; }
+private:
+    double stepSeconds;
+    uint32_t maxStepsPerFrame;
+    double accumulator = 0.0;
+    uint64_t stepCount = 0;
+};
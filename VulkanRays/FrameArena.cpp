@@ -0,0 +1,72 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+unsigned char* alignPointer(unsigned char* p, size_t alignment) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    return p + ((alignment - address % alignment) % alignment);
+}
+}
+
+FrameArena::FrameArena(size_t capacity) : capacity(capacity) {
+    base = static_cast<unsigned char*>(::operator new(capacity));
+}
+
+FrameArena::~FrameArena() {
+    for (void* block : overflow) ::operator delete(block);
+    ::operator delete(base);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment, const char* tag) {
+    unsigned char* p = alignPointer(base + used, alignment);
+    size_t end = (size_t)(p - base) + size;
+#if FRAME_ARENA_DEBUG
+    noteTag(tag, size);
+#else
+    (void)tag;
+#endif
+    if (end <= capacity) {
+        used = end;
+        return p;
+    }
+    // Out of room: heap for the rest of this frame, reset() grows the arena to fit next time
+    void* block = ::operator new(size + alignment);
+    overflow.push_back(block);
+    overflowBytes += size + alignment;
+    ++overflowCount;
+    return alignPointer(static_cast<unsigned char*>(block), alignment);
+}
+
+void FrameArena::reset() {
+    lastFrameBytes = used + overflowBytes;
+    highWater = std::max(highWater, lastFrameBytes);
+#if FRAME_ARENA_DEBUG
+    // Anything still holding last frame's pointers reads garbage instead of stale data
+    std::memset(base, 0xCD, used);
+    for (uint32_t i = 0; i < tagCount; ++i) tags[i].bytes = 0;
+#endif
+    used = 0;
+    if (overflow.empty()) return;
+    for (void* block : overflow) ::operator delete(block);
+    overflow.clear();
+    overflowBytes = 0;
+    // Grow with some headroom so a slowly growing scene doesn't overflow every few frames
+    size_t grown = std::max(capacity * 2, highWater + highWater / 2);
+    ::operator delete(base);
+    base = static_cast<unsigned char*>(::operator new(grown));
+    capacity = grown;
+}
+
+void FrameArena::noteTag(const char* tag, size_t bytes) {
+    if (!tag) tag = "untagged";
+    uint32_t i = 0;
+    while (i < tagCount && tags[i].tag != tag && std::strcmp(tags[i].tag, tag) != 0) ++i;
+    if (i == tagCount) {
+        if (tagCount == MAX_TAGS) return;
+        tags[tagCount++].tag = tag;
+    }
+    tags[i].bytes += bytes;
+    tags[i].highWater = std::max(tags[i].highWater, tags[i].bytes);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Debug builds poison released memory and keep per-tag high-water marks
+#if !defined(FRAME_ARENA_DEBUG) && !defined(NDEBUG)
+#define FRAME_ARENA_DEBUG 1
+#endif
+
+// --- FrameArena: per-frame linear allocator for transient CPU data ---
+// One per frame in flight (FrameContext). Everything a frame builds on the CPU and drops
+// once it is recorded (matrices, draw lists, sort keys, culling results) is a pointer bump
+// here; reset() releases all of it at once when the frame that used the arena has retired.
+// Memory is never constructed or destructed, so only trivially destructible types fit.
+// A frame that outgrows the arena falls back to the heap for the rest of that frame, and
+// the next reset() grows the arena to the frame's high-water mark, so steady state never
+// allocates. Main thread only: workers read what the main thread prepared.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity);
+    ~FrameArena();
+
+    // tag: string literal naming the user (only looked at in FRAME_ARENA_DEBUG builds)
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t), const char* tag = nullptr);
+    template <typename T>
+    T* allocateArray(size_t count, const char* tag = nullptr) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is released without destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T), tag));
+    }
+    void reset();
+
+    size_t getCapacity() const { return capacity; }
+    size_t getUsed() const { return used + overflowBytes; }
+    size_t getLastFrameBytes() const { return lastFrameBytes; } // used by the frame before the last reset()
+    size_t getHighWater() const { return highWater; }
+    uint64_t getOverflowCount() const { return overflowCount; } // heap fallbacks since creation
+
+    struct TagStats {
+        const char* tag = nullptr;
+        size_t bytes = 0;      // this frame
+        size_t highWater = 0;  // any frame
+    };
+    static constexpr uint32_t MAX_TAGS = 16;
+    uint32_t getTagCount() const { return tagCount; }
+    const TagStats& getTag(uint32_t i) const { return tags[i]; }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+private:
+    unsigned char* base = nullptr;
+    size_t capacity;
+    size_t used = 0;
+    size_t overflowBytes = 0;
+    size_t lastFrameBytes = 0;
+    size_t highWater = 0;
+    uint64_t overflowCount = 0;
+    std::vector<void*> overflow;   // heap fallbacks of the current frame
+    TagStats tags[MAX_TAGS];
+    uint32_t tagCount = 0;
+    void noteTag(const char* tag, size_t bytes);
+};
@@ -0,0 +1,131 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "CpuTrace.h"
+
+FrameScheduler::FrameScheduler(VkDevice device, uint32_t maxFramesInFlight)
+    : device(device), maxFramesInFlight(maxFramesInFlight) {
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semInfo.pNext = &typeInfo;
+    if (vkCreateSemaphore(device, &semInfo, nullptr, &timeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create timeline semaphore");
+}
+
+FrameScheduler::~FrameScheduler() {
+    for (auto s : renderFinishedSemaphores) if (s) vkDestroySemaphore(device, s, nullptr);
+    if (timeline) vkDestroySemaphore(device, timeline, nullptr);
+}
+
+VkSemaphore FrameScheduler::createBinarySemaphore() {
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkSemaphore s = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(device, &semInfo, nullptr, &s) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create sync objects");
+    return s;
+}
+
+void FrameScheduler::resizeRenderFinishedSemaphores(size_t imageCount) {
+    // Caller guarantees the destroyed semaphores are idle (startup, or after detaching them)
+    while (renderFinishedSemaphores.size() > imageCount) {
+        vkDestroySemaphore(device, renderFinishedSemaphores.back(), nullptr);
+        renderFinishedSemaphores.pop_back();
+    }
+    while (renderFinishedSemaphores.size() < imageCount)
+        renderFinishedSemaphores.push_back(createBinarySemaphore());
+}
+
+std::vector<VkSemaphore> FrameScheduler::detachRenderFinishedSemaphores() {
+    std::vector<VkSemaphore> detached;
+    detached.swap(renderFinishedSemaphores);
+    return detached;
+}
+
+uint64_t FrameScheduler::beginFrame() {
+    currentTicket = submittedTicket + 1;
+    auto waitStart = std::chrono::steady_clock::now();
+    if (currentTicket > maxFramesInFlight)
+        waitForFrame(currentTicket - maxFramesInFlight);
+    lastWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+    return currentTicket;
+}
+
+void FrameScheduler::submit(VkQueue queue, VkCommandBuffer cmd, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore) {
+    TRACE_ZONE("submit");
+    // Binary semaphores ignore their entry in the value arrays, but the counts must match
+    VkSemaphore signalSemaphores[] = { timeline, signalSemaphore };
+    uint64_t signalValues[] = { currentTicket, 0 };
+    VkSemaphore waitSemaphores[MAX_EXTRA_WAITS + 1];
+    uint64_t waitValues[MAX_EXTRA_WAITS + 1];
+    VkPipelineStageFlags waitStages[MAX_EXTRA_WAITS + 1];
+    uint32_t waitCount = 0;
+    if (waitSemaphore) {
+        waitSemaphores[waitCount] = waitSemaphore;
+        waitValues[waitCount] = 0;
+        waitStages[waitCount++] = waitStage;
+    }
+    for (uint32_t i = 0; i < extraWaitCount; ++i) {
+        waitSemaphores[waitCount] = extraWaits[i];
+        waitValues[waitCount] = extraWaitValues[i];
+        waitStages[waitCount++] = extraWaitStages[i];
+    }
+    extraWaitCount = 0;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = signalSemaphore ? 2 : 1;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = waitCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = signalSemaphore ? 2 : 1;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit draw command buffer");
+    submittedTicket = currentTicket;
+}
+
+void FrameScheduler::waitOnNextSubmit(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage) {
+    // Same semaphore again: the later value covers the earlier one
+    for (uint32_t i = 0; i < extraWaitCount; ++i) {
+        if (extraWaits[i] == semaphore) {
+            extraWaitValues[i] = std::max(extraWaitValues[i], value);
+            extraWaitStages[i] |= stage;
+            return;
+        }
+    }
+    if (extraWaitCount == MAX_EXTRA_WAITS) throw std::runtime_error("Failed to add submit wait: too many semaphores");
+    extraWaits[extraWaitCount] = semaphore;
+    extraWaitValues[extraWaitCount] = value;
+    extraWaitStages[extraWaitCount++] = stage;
+}
+
+void FrameScheduler::waitForFrame(uint64_t ticket) {
+    if (ticket == 0 || getCompletedTicket() >= ticket) return;
+    TRACE_ZONE("waitForFrame");
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timeline;
+    waitInfo.pValues = &ticket;
+    if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+        throw std::runtime_error("Failed to wait for frame timeline");
+}
+
+uint64_t FrameScheduler::getCompletedTicket() const {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device, timeline, &value);
+    return value;
+}
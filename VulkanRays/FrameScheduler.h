@@ -0,0 +1,61 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+// --- FrameScheduler: timeline-semaphore frame pacing ---
+// Hands out monotonically increasing frame tickets. Ticket N is signaled on a single
+// timeline semaphore once the GPU has finished the work submitted for frame N, so the
+// CPU waits on "frame N - maxFramesInFlight done" instead of resetting per-slot fences.
+// A ticket is only consumed by submit(): bailing out between beginFrame() and submit()
+// (e.g. VK_ERROR_OUT_OF_DATE_KHR on acquire) simply hands the same ticket out again.
+class FrameScheduler {
+public:
+    FrameScheduler(VkDevice device, uint32_t maxFramesInFlight);
+    ~FrameScheduler();
+
+    // Blocks until the frame that last used this frame slot has retired on the GPU and
+    // returns the ticket of the frame about to be recorded.
+    uint64_t beginFrame();
+    // Adds a timeline wait (e.g. an upload batch) to the next submit() only
+    void waitOnNextSubmit(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage);
+    // Submits cmd for the current ticket and signals the timeline with it.
+    void submit(VkQueue queue, VkCommandBuffer cmd, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore);
+
+    void waitForFrame(uint64_t ticket);
+    void waitIdle() { waitForFrame(submittedTicket); }
+
+    uint64_t getCurrentTicket() const { return currentTicket; }
+    uint64_t getSubmittedTicket() const { return submittedTicket; }
+    uint64_t getCompletedTicket() const;
+    uint32_t getFrameSlot() const { return static_cast<uint32_t>(currentTicket % maxFramesInFlight); }
+    uint32_t getMaxFramesInFlight() const { return maxFramesInFlight; }
+    VkSemaphore getTimelineSemaphore() const { return timeline; }
+
+    // Present semaphores are per swapchain image (an image's semaphore is only reused once
+    // that image is acquired again); acquire semaphores live in each FrameContext.
+    VkSemaphore getRenderFinishedSemaphore(uint32_t imageIndex) const { return renderFinishedSemaphores[imageIndex]; }
+    void resizeRenderFinishedSemaphores(size_t imageCount);
+    // Swapchain recreation: the caller takes the current semaphores over (and destroys them
+    // once the presents waiting on them are done); resizeRenderFinishedSemaphores() then
+    // creates fresh ones
+    std::vector<VkSemaphore> detachRenderFinishedSemaphores();
+
+    // CPU time spent blocked on the GPU in the last beginFrame(). Close to zero means the
+    // frame is CPU-bound; close to the frame time means it is GPU-bound.
+    double getLastWaitMs() const { return lastWaitMs; }
+private:
+    VkDevice device;
+    uint32_t maxFramesInFlight;
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    std::vector<VkSemaphore> renderFinishedSemaphores;
+    uint64_t currentTicket = 0;
+    uint64_t submittedTicket = 0;
+    double lastWaitMs = 0.0;
+    static constexpr uint32_t MAX_EXTRA_WAITS = 4;
+    VkSemaphore extraWaits[MAX_EXTRA_WAITS] = {};
+    uint64_t extraWaitValues[MAX_EXTRA_WAITS] = {};
+    VkPipelineStageFlags extraWaitStages[MAX_EXTRA_WAITS] = {};
+    uint32_t extraWaitCount = 0;
+    VkSemaphore createBinarySemaphore();
+};
@@ -0,0 +1,418 @@
+#include "GpuCuller.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include "shaders/cull.comp.inc"
+#include "shaders/cull_objects.comp.inc"
+
+namespace {
+// Matches the push constant block in shaders/cull.comp (116 of the 128 guaranteed bytes)
+struct CullConstants {
+    float planes[6][4];
+    float sphere[4];
+    uint32_t instanceCount;
+};
+// Matches the push constant block in shaders/cull_objects.comp
+struct ObjectCullConstants {
+    uint32_t slot;
+    uint32_t objectCount;
+};
+constexpr uint32_t CULL_GROUP_SIZE = 64; // local_size_x of both shaders
+
+VkPipeline CreateComputePipeline(VkDevice device, VkPipelineLayout layout, const unsigned char* code, size_t codeSize) {
+    VkShaderModule shaderModule;
+    VkShaderModuleCreateInfo shaderInfo{};
+    shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderInfo.codeSize = codeSize;
+    shaderInfo.pCode = reinterpret_cast<const uint32_t*>(code);
+    if (vkCreateShaderModule(device, &shaderInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cull shader module");
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = layout;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+    if (result != VK_SUCCESS) throw std::runtime_error("Failed to create cull pipeline");
+    return pipeline;
+}
+
+VkDescriptorSetLayout CreateStorageSetLayout(VkDevice device, uint32_t bindingCount) {
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    for (uint32_t i = 0; i < bindingCount; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = bindingCount;
+    layoutInfo.pBindings = bindings;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cull descriptor set layout");
+    return setLayout;
+}
+}
+
+GpuCuller::GpuCuller(VulkanDevice& device, uint32_t frameCount, VkDescriptorSetLayout transformSetLayout)
+    : device(device), slots(frameCount) {
+    // 0: instances (read), 1: visible instances (written), 2: the draw command (atomic count)
+    setLayout = CreateStorageSetLayout(device.getDevice(), 3);
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullConstants);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device.getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cull pipeline layout");
+
+    pipeline = CreateComputePipeline(device.getDevice(), pipelineLayout, cull_comp_spv, cull_comp_spv_len);
+    if (transformSetLayout) createObjectPipeline(transformSetLayout);
+
+    // One set per frame slot (two with object culling): a slot's sets are only rewritten once
+    // its last frame has retired
+    uint32_t setsPerSlot = objectPipeline ? 2 : 1;
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 3 * setsPerSlot * frameCount;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = setsPerSlot * frameCount;
+    if (vkCreateDescriptorPool(device.getDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create cull descriptor pool");
+    std::vector<VkDescriptorSetLayout> layouts(frameCount, setLayout);
+    layouts.resize(setsPerSlot * frameCount, objectSetLayout);
+    std::vector<VkDescriptorSet> sets(setsPerSlot * frameCount);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = setsPerSlot * frameCount;
+    allocInfo.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device.getDevice(), &allocInfo, sets.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate cull descriptor sets");
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        slots[i].set = sets[i];
+        if (objectPipeline) slots[i].objectSet = sets[frameCount + i];
+        slots[i].readback = std::make_unique<VulkanBuffer>(device, device.getPhysicalDevice(), sizeof(uint32_t),
+                                                           VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                           MemoryCategory::Staging);
+    }
+    drawBuffer = std::make_unique<VulkanBuffer>(device, device.getPhysicalDevice(), sizeof(VkDrawIndexedIndirectCommand),
+                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Other);
+}
+
+GpuCuller::~GpuCuller() {
+    slots.clear();
+    visibleBuffer.reset();
+    drawBuffer.reset();
+    objectCommands.reset();
+    objectCounts.reset();
+    // The sets go with their pool
+    if (pipeline) vkDestroyPipeline(device.getDevice(), pipeline, nullptr);
+    if (pipelineLayout) vkDestroyPipelineLayout(device.getDevice(), pipelineLayout, nullptr);
+    if (objectPipeline) vkDestroyPipeline(device.getDevice(), objectPipeline, nullptr);
+    if (objectPipelineLayout) vkDestroyPipelineLayout(device.getDevice(), objectPipelineLayout, nullptr);
+    if (objectSetLayout) vkDestroyDescriptorSetLayout(device.getDevice(), objectSetLayout, nullptr);
+    if (pool) vkDestroyDescriptorPool(device.getDevice(), pool, nullptr);
+    if (setLayout) vkDestroyDescriptorSetLayout(device.getDevice(), setLayout, nullptr);
+}
+
+void GpuCuller::writeSet(Slot& slot, VkBuffer instances) {
+    VkDescriptorBufferInfo bufferInfos[3] = {
+        { instances, 0, VK_WHOLE_SIZE },
+        { visibleBuffer->getBuffer(), 0, VK_WHOLE_SIZE },
+        { drawBuffer->getBuffer(), 0, VK_WHOLE_SIZE },
+    };
+    VkWriteDescriptorSet writes[3] = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = slot.set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(device.getDevice(), 3, writes, 0, nullptr);
+    slot.boundInstances = instances;
+    slot.boundVisible = visibleBuffer->getBuffer();
+    slot.boundDraw = drawBuffer->getBuffer();
+}
+
+void GpuCuller::record(VkCommandBuffer cmd, uint32_t frameSlot, const InstancedMeshObject& mesh, const Mat4& mvp,
+                       DeletionQueue& buffers, DrawBinding& binding) {
+    Slot& slot = slots[frameSlot];
+    uint32_t instanceCount = mesh.getDrawCount();
+    slot.submitted = instanceCount;
+    slot.pending = instanceCount > 0;
+    if (instanceCount == 0) return;
+    // Worst case every instance survives; double so a growing scene reallocates rarely
+    if (instanceCount > visibleCapacity) {
+        visibleCapacity = std::max(instanceCount, visibleCapacity * 2);
+        buffers.release(std::move(visibleBuffer)); // frames in flight still draw from it
+        visibleBuffer = buffers.acquireBuffer((VkDeviceSize)visibleCapacity * sizeof(InstanceData),
+                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry);
+    }
+    if (slot.boundInstances != mesh.getInstanceBuffer() || slot.boundVisible != visibleBuffer->getBuffer() ||
+        slot.boundDraw != drawBuffer->getBuffer())
+        writeSet(slot, mesh.getInstanceBuffer());
+
+    // Earlier frames' draw (command and instance reads) and readback vs. this frame's reset
+    // and writes; the instance copies recorded just before only targeted vertex input
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                            VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    // One draw of the whole mesh; the shader counts the instances up from 0
+    VkDrawIndexedIndirectCommand command{ mesh.getIndexCount(), 0, 0, 0, 0 };
+    vkCmdUpdateBuffer(cmd, drawBuffer->getBuffer(), 0, sizeof(command), &command);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    CullConstants constants{};
+    frustumPlanes(mvp, constants.planes);
+    mesh.getBoundingSphere(constants.sphere);
+    constants.instanceCount = instanceCount;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &slot.set, 0, nullptr);
+    vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &constants);
+    vkCmdDispatch(cmd, (instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // Survivors and their count to the indirect draw, and the count to this slot's readback buffer
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    VkBufferCopy copy{ offsetof(VkDrawIndexedIndirectCommand, instanceCount), 0, sizeof(uint32_t) };
+    vkCmdCopyBuffer(cmd, drawBuffer->getBuffer(), slot.readback->getBuffer(), 1, &copy);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    binding.indirectBuffer = drawBuffer->getBuffer();
+    binding.indirectInstances = visibleBuffer->getBuffer();
+}
+
+void GpuCuller::collect(uint32_t frameSlot) {
+    Slot& slot = slots[frameSlot];
+    if (slot.objectsPending) {
+        slot.objectsPending = false;
+        slot.objectReadback->downloadData(countScratch.data(), (VkDeviceSize)slot.readbackBatches * sizeof(uint32_t));
+        stats.objectsSubmitted = slot.objectsSubmitted;
+        stats.objectsDrawn = 0;
+        for (uint32_t b = 0; b < slot.readbackBatches; ++b) stats.objectsDrawn += countScratch[b];
+    }
+    if (!slot.pending) return;
+    slot.pending = false;
+    uint32_t drawn = 0;
+    slot.readback->downloadData(&drawn, sizeof(drawn));
+    stats.submitted = slot.submitted;
+    stats.drawn = drawn;
+}
+
+// --- Plain objects ---
+void GpuCuller::createObjectPipeline(VkDescriptorSetLayout transformSetLayout) {
+    // Set 1 -- 0: ObjectDraw table (read), 1: draw commands (written), 2: per-batch counts (atomic)
+    objectSetLayout = CreateStorageSetLayout(device.getDevice(), 3);
+    VkDescriptorSetLayout setLayouts[2] = { transformSetLayout, objectSetLayout };
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ObjectCullConstants);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 2;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device.getDevice(), &pipelineLayoutInfo, nullptr, &objectPipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create object cull pipeline layout");
+    objectPipeline = CreateComputePipeline(device.getDevice(), objectPipelineLayout, cull_objects_comp_spv, cull_objects_comp_spv_len);
+}
+
+void GpuCuller::buildBatches(const std::vector<std::unique_ptr<RenderObject>>& objects) {
+    // Objects that can share a vkCmdDrawIndexedIndirectCount: same topology (so the same
+    // pipeline on the bindless path) and the same mesh buffers. A scene has a handful of these.
+    struct Key {
+        VulkanPipeline::Topology topology;
+        MeshBuffers mesh;
+        uint32_t objectCount;
+        uint32_t firstBatch;
+        uint32_t placed;
+    };
+    std::vector<Key> keys;
+    std::vector<uint32_t> keyOf(objects.size(), UINT32_MAX);
+    unculled.clear();
+    for (uint32_t i = 0; i < (uint32_t)objects.size(); ++i) {
+        const RenderObject& obj = *objects[i];
+        if (obj.getVertexInput() != VulkanPipeline::VertexInput::PerVertex) {
+            unculled.push_back(i);
+            continue;
+        }
+        MeshBuffers mesh = obj.getMeshBuffers();
+        uint32_t k = 0;
+        while (k < keys.size() && !(keys[k].topology == obj.getTopology() && keys[k].mesh.vertex[0] == mesh.vertex[0] &&
+                                    keys[k].mesh.index == mesh.index)) ++k;
+        if (k == keys.size()) keys.push_back({ obj.getTopology(), mesh, 0, 0, 0 });
+        ++keys[k].objectCount;
+        keyOf[i] = k;
+    }
+    // Split into batches of at most maxDrawIndirectCount draws, commands packed in key order
+    uint32_t maxDraws = std::max<uint32_t>(device.getProperties().limits.maxDrawIndirectCount, 1);
+    batches.clear();
+    uint32_t commandBase = 0;
+    for (Key& key : keys) {
+        key.firstBatch = (uint32_t)batches.size();
+        for (uint32_t left = key.objectCount; left > 0;) {
+            uint32_t draws = std::min(left, maxDraws);
+            batches.push_back({ 0, commandBase, draws });
+            commandBase += draws;
+            left -= draws;
+        }
+    }
+    table.clear();
+    for (uint32_t i = 0; i < (uint32_t)objects.size(); ++i) {
+        if (keyOf[i] == UINT32_MAX) continue;
+        Key& key = keys[keyOf[i]];
+        uint32_t b = key.firstBatch + key.placed / maxDraws;
+        if (key.placed % maxDraws == 0) batches[b].object = i;
+        ++key.placed;
+        ObjectDraw row{};
+        objects[i]->getBoundingSphere(row.sphere);
+        row.indexCount = objects[i]->getIndexCount();
+        row.batch = b;
+        row.commandBase = batches[b].commandBase;
+        row.object = i;
+        table.push_back(row);
+    }
+}
+
+void GpuCuller::writeObjectSet(Slot& slot) {
+    VkDescriptorBufferInfo bufferInfos[3] = {
+        { slot.table->getBuffer(), 0, VK_WHOLE_SIZE },
+        { objectCommands->getBuffer(), 0, VK_WHOLE_SIZE },
+        { objectCounts->getBuffer(), 0, VK_WHOLE_SIZE },
+    };
+    VkWriteDescriptorSet writes[3] = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = slot.objectSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(device.getDevice(), 3, writes, 0, nullptr);
+    slot.boundTable = slot.table->getBuffer();
+    slot.boundCommands = objectCommands->getBuffer();
+    slot.boundCounts = objectCounts->getBuffer();
+}
+
+void GpuCuller::recordObjects(VkCommandBuffer cmd, uint32_t frameSlot, const std::vector<std::unique_ptr<RenderObject>>& objects,
+                              uint64_t version, const TransformBuffer& transforms, DeletionQueue& buffers) {
+    Slot& slot = slots[frameSlot];
+    if (version != batchVersion) {
+        buildBatches(objects);
+        batchVersion = version;
+    }
+    uint32_t objectCount = (uint32_t)table.size();
+    uint32_t batchCount = (uint32_t)batches.size();
+    slot.objectsSubmitted = objectCount;
+    slot.objectsPending = objectCount > 0;
+    slot.readbackBatches = batchCount;
+    if (objectCount == 0) return;
+    // Shared buffers: frames in flight may still draw from the old ones. Doubled, so adding
+    // objects one at a time reallocates rarely.
+    if (objectCount > commandCapacity) {
+        commandCapacity = std::max(objectCount, commandCapacity * 2);
+        buffers.release(std::move(objectCommands));
+        objectCommands = buffers.acquireBuffer((VkDeviceSize)commandCapacity * sizeof(VkDrawIndexedIndirectCommand),
+                                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Other);
+    }
+    if (batchCount > countCapacity) {
+        countCapacity = std::max(batchCount, countCapacity * 2);
+        countScratch.resize(countCapacity);
+        buffers.release(std::move(objectCounts));
+        objectCounts = buffers.acquireBuffer((VkDeviceSize)countCapacity * sizeof(uint32_t),
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Other);
+    }
+    // The slot's own buffers: its last frame has retired, so they are replaced or rewritten in place
+    if (!slot.objectReadback || slot.objectReadback->getSize() < (VkDeviceSize)countCapacity * sizeof(uint32_t))
+        slot.objectReadback = std::make_unique<VulkanBuffer>(device, device.getPhysicalDevice(), (VkDeviceSize)countCapacity * sizeof(uint32_t),
+                                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                             MemoryCategory::Staging);
+    if (slot.tableVersion != batchVersion) {
+        if (!slot.table || slot.table->getSize() < (VkDeviceSize)commandCapacity * sizeof(ObjectDraw))
+            slot.table = std::make_unique<VulkanBuffer>(device, device.getPhysicalDevice(), (VkDeviceSize)commandCapacity * sizeof(ObjectDraw),
+                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                        MemoryCategory::Uniforms);
+        slot.table->write(0, table.data(), (VkDeviceSize)objectCount * sizeof(ObjectDraw));
+        slot.tableVersion = batchVersion;
+    }
+    if (slot.boundTable != slot.table->getBuffer() || slot.boundCommands != objectCommands->getBuffer() ||
+        slot.boundCounts != objectCounts->getBuffer())
+        writeObjectSet(slot);
+
+    // Earlier frames' indirect reads and count readback vs. this frame's reset and writes
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    vkCmdFillBuffer(cmd, objectCounts->getBuffer(), 0, (VkDeviceSize)batchCount * sizeof(uint32_t), 0);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    ObjectCullConstants constants{ frameSlot, objectCount };
+    VkDescriptorSet sets[2] = { transforms.getSet(), slot.objectSet };
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, objectPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, objectPipelineLayout, 0, 2, sets, 0, nullptr);
+    vkCmdPushConstants(cmd, objectPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmd, (objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // Commands and counts to the indirect draws, and the counts to this slot's readback buffer
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    VkBufferCopy copy{ 0, 0, (VkDeviceSize)batchCount * sizeof(uint32_t) };
+    vkCmdCopyBuffer(cmd, objectCounts->getBuffer(), slot.objectReadback->getBuffer(), 1, &copy);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::bindObjectBatch(uint32_t batch, DrawBinding& binding) const {
+    const ObjectBatch& b = batches[batch];
+    binding.indirectBuffer = objectCommands->getBuffer();
+    binding.indirectOffset = (VkDeviceSize)b.commandBase * sizeof(VkDrawIndexedIndirectCommand);
+    binding.indirectCount = objectCounts->getBuffer();
+    binding.countOffset = (VkDeviceSize)batch * sizeof(uint32_t);
+    binding.maxDrawCount = b.maxDraws;
+}
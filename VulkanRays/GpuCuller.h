@@ -0,0 +1,135 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "DeletionQueue.h"
+#include "RenderObject.h"
+#include "TransformBuffer.h"
+#include "MathUtils.h"
+
+// --- GpuCuller: compute frustum culling feeding one vkCmdDrawIndexedIndirect ---
+// record() runs shaders/cull.comp over an InstancedMeshObject's instance buffer before the
+// render pass: one thread per instance tests the mesh's bounding sphere, moved and scaled by
+// the instance transform, against the frustum planes of the object's MVP, and copies each
+// survivor into a packed visible-instance buffer, bumping the instanceCount of a single
+// VkDrawIndexedIndirectCommand with an atomic. The draw stays one instanced draw: it binds
+// the visible buffer as the instance stream and reads its command straight from the GPU, so
+// the CPU records the same few commands whatever the instance count. The instance count is
+// also copied to a host-visible buffer per frame slot and read back once that frame has
+// retired (submitted vs drawn).
+// recordObjects() does the same for the scene's plain (non-instanced) objects on the bindless
+// draw path, where their MVPs already sit in the TransformBuffer: shaders/cull_objects.comp
+// runs one thread per object, pulls the frustum planes out of that object's MVP and, for a
+// survivor, appends a VkDrawIndexedIndirectCommand (firstInstance = object index) to its
+// batch. A batch is every object sharing a topology and mesh buffers, so the pyramids are one
+// batch and the grid another; each batch is one vkCmdDrawIndexedIndirectCount reading its
+// count from the GPU. The per-object table and the batches are only rebuilt when the scene
+// changes, so recording is a fixed handful of commands whatever the object count.
+// Needs VulkanDevice::hasGpuDrivenDraws(); objects also need hasIndirectCount() and a
+// TransformBuffer.
+struct CullStats {
+    uint32_t submitted = 0; // instances the last collected frame tested
+    uint32_t drawn = 0;     // ... and drew
+    uint32_t objectsSubmitted = 0; // plain objects the last collected frame tested
+    uint32_t objectsDrawn = 0;     // ... and drew
+};
+
+// One vkCmdDrawIndexedIndirectCount: objects that share a topology and mesh buffers
+struct ObjectBatch {
+    uint32_t object = 0;      // first object of the batch: the pipeline and mesh come from it
+    uint32_t commandBase = 0; // first of its commands in the object command buffer
+    uint32_t maxDraws = 0;    // objects in the batch (at most maxDrawIndirectCount)
+};
+
+class GpuCuller {
+public:
+    // transformSetLayout: the TransformBuffer's, for recordObjects(); null = instances only
+    GpuCuller(VulkanDevice& device, uint32_t frameCount, VkDescriptorSetLayout transformSetLayout = VK_NULL_HANDLE);
+    ~GpuCuller();
+
+    // Outside a render pass, after the mesh's recordUpdates(). mvp: view-projection times the
+    // object's model matrix, as pushed for the draw. Fills binding's indirect fields for recordDraw().
+    void record(VkCommandBuffer cmd, uint32_t frameSlot, const InstancedMeshObject& mesh, const Mat4& mvp,
+                DeletionQueue& buffers, DrawBinding& binding);
+    // Outside a render pass, once this frame's MVPs are in transforms. version: anything that
+    // changes whenever objects are added or removed; the batches are rebuilt when it does.
+    void recordObjects(VkCommandBuffer cmd, uint32_t frameSlot, const std::vector<std::unique_ptr<RenderObject>>& objects,
+                       uint64_t version, const TransformBuffer& transforms, DeletionQueue& buffers);
+    // From the last recordObjects(): the batches to draw, and the objects they leave out
+    // (instanced ones), which are drawn as usual
+    const std::vector<ObjectBatch>& getObjectBatches() const { return batches; }
+    const std::vector<uint32_t>& getUnculledObjects() const { return unculled; }
+    // Fills binding's indirect fields for the batch's recordDraw()
+    void bindObjectBatch(uint32_t batch, DrawBinding& binding) const;
+    // recordObjects() is available (the device has drawIndirectCount and a transform set layout was given)
+    bool cullsObjects() const { return objectPipeline != VK_NULL_HANDLE; }
+    // Once the frame that last used frameSlot has retired
+    void collect(uint32_t frameSlot);
+    const CullStats& getStats() const { return stats; }
+
+    GpuCuller(const GpuCuller&) = delete;
+    GpuCuller& operator=(const GpuCuller&) = delete;
+private:
+    struct Slot {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkBuffer boundInstances = VK_NULL_HANDLE; // what set points at, rewritten when any changes
+        VkBuffer boundVisible = VK_NULL_HANDLE;   // (growth, or the defragmenter moving the
+        VkBuffer boundDraw = VK_NULL_HANDLE;      // instance or draw buffer)
+        std::unique_ptr<VulkanBuffer> readback;   // drawn count of the slot's last frame
+        uint32_t submitted = 0;
+        bool pending = false;
+        // Plain objects
+        VkDescriptorSet objectSet = VK_NULL_HANDLE;
+        VkBuffer boundTable = VK_NULL_HANDLE;
+        VkBuffer boundCommands = VK_NULL_HANDLE;
+        VkBuffer boundCounts = VK_NULL_HANDLE;
+        std::unique_ptr<VulkanBuffer> table;        // ObjectDraw per object, host-visible
+        uint64_t tableVersion = UINT64_MAX;         // scene version table holds
+        std::unique_ptr<VulkanBuffer> objectReadback; // per-batch counts of the slot's last frame
+        uint32_t objectsSubmitted = 0;
+        uint32_t readbackBatches = 0;
+        bool objectsPending = false;
+    };
+    // Matches struct ObjectDraw in shaders/cull_objects.comp
+    struct ObjectDraw {
+        float sphere[4];
+        uint32_t indexCount;
+        uint32_t batch;
+        uint32_t commandBase;
+        uint32_t object;
+    };
+    VulkanDevice& device;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    // Shared by all frames: same queue, so barriers order each frame's writes after the
+    // previous frame's indirect reads
+    std::unique_ptr<VulkanBuffer> visibleBuffer; // InstanceData per survivor, vertex binding 1 of the draw
+    std::unique_ptr<VulkanBuffer> drawBuffer;    // the one VkDrawIndexedIndirectCommand
+    uint32_t visibleCapacity = 0;
+    std::vector<Slot> slots;
+    CullStats stats;
+    // Plain objects: the compute pipeline (set 0 is the TransformBuffer's), and the command
+    // and per-batch count buffers, shared by all frames like the instance buffers above
+    VkDescriptorSetLayout objectSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout objectPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline objectPipeline = VK_NULL_HANDLE;
+    std::unique_ptr<VulkanBuffer> objectCommands; // VkDrawIndexedIndirectCommand per object
+    std::unique_ptr<VulkanBuffer> objectCounts;   // uint32_t per batch
+    uint32_t commandCapacity = 0;
+    uint32_t countCapacity = 0;
+    uint64_t batchVersion = UINT64_MAX;
+    std::vector<ObjectBatch> batches;
+    std::vector<uint32_t> unculled;
+    std::vector<ObjectDraw> table;
+    std::vector<uint32_t> countScratch; // collect() reads a slot's counts into this
+
+    void writeSet(Slot& slot, VkBuffer instances);
+    void createObjectPipeline(VkDescriptorSetLayout transformSetLayout);
+    void buildBatches(const std::vector<std::unique_ptr<RenderObject>>& objects);
+    void writeObjectSet(Slot& slot);
+};
@@ -0,0 +1,81 @@
+#include "GpuProfiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+GpuProfiler::GpuProfiler(VulkanDevice& vulkanDevice, uint32_t framesInFlight, uint32_t maxScopesPerFrame)
+    : device(vulkanDevice.getDevice()), maxScopes(maxScopesPerFrame), slices(framesInFlight) {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vulkanDevice.getPhysicalDevice(), &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(vulkanDevice.getPhysicalDevice(), &familyCount, families.data());
+    uint32_t validBits = families[vulkanDevice.getGraphicsQueueFamily()].timestampValidBits;
+    if (validBits == 0) return; // no timestamps on this queue: profiler stays disabled
+    if (validBits < 64) timestampMask = (1ull << validBits) - 1;
+    timestampPeriodNs = vulkanDevice.getProperties().limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryInfo{};
+    queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = framesInFlight * maxScopes * 2;
+    if (vkCreateQueryPool(device, &queryInfo, nullptr, &queryPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create timestamp query pool");
+    for (auto& slice : slices) slice.scopes.reserve(maxScopes);
+    ticks.resize(maxScopes * 2);
+    results.reserve(maxScopes);
+}
+
+GpuProfiler::~GpuProfiler() {
+    if (queryPool) vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+bool GpuProfiler::collect(uint32_t slot) {
+    Slice& slice = slices[slot];
+    if (!queryPool || !slice.pending || slice.scopes.empty()) return false;
+    uint32_t queryCount = (uint32_t)slice.scopes.size() * 2;
+    // No VK_QUERY_RESULT_WAIT_BIT: if the GPU is somehow not done, keep the previous results
+    VkResult result = vkGetQueryPoolResults(device, queryPool, slot * maxScopes * 2, queryCount,
+                                            queryCount * sizeof(uint64_t), ticks.data(), sizeof(uint64_t),
+                                            VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) return false;
+    slice.pending = false;
+    results.clear();
+    uint64_t first = UINT64_MAX, last = 0;
+    for (size_t i = 0; i < slice.scopes.size(); ++i) {
+        uint64_t begin = ticks[i * 2] & timestampMask;
+        uint64_t end = ticks[i * 2 + 1] & timestampMask;
+        first = std::min(first, begin);
+        last = std::max(last, end);
+        const ScopeRecord& scope = slice.scopes[i];
+        results.push_back({ scope.name, scope.index, scope.depth, (end - begin) * timestampPeriodNs * 1e-6 });
+    }
+    frameMs = (last - first) * timestampPeriodNs * 1e-6;
+    return true;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer cmd, uint32_t slot) {
+    if (!queryPool) return;
+    currentSlot = slot;
+    currentDepth = 0;
+    Slice& slice = slices[slot];
+    slice.scopes.clear();
+    slice.pending = true;
+    vkCmdResetQueryPool(cmd, queryPool, slot * maxScopes * 2, maxScopes * 2);
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer cmd, const char* name, int32_t index) {
+    Slice& slice = slices[currentSlot];
+    if (!queryPool || slice.scopes.size() >= maxScopes) {
+        ++currentDepth; // keep nesting consistent for the scopes that do fit
+        return UINT32_MAX;
+    }
+    uint32_t id = (uint32_t)slice.scopes.size();
+    slice.scopes.push_back({ name, index, currentDepth++ });
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, (currentSlot * maxScopes + id) * 2);
+    return id;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer cmd, uint32_t scopeId) {
+    --currentDepth;
+    if (scopeId == UINT32_MAX) return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, (currentSlot * maxScopes + scopeId) * 2 + 1);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include "VulkanDevice.h"
+
+// --- GpuProfiler: timestamp scopes per frame in flight ---
+// One VkQueryPool, split into a slice per frame in flight. Scopes are recorded as
+// begin/end timestamp pairs and may nest; a slice is read back (without waiting) when its
+// frame slot comes round again, i.e. once FrameScheduler says that frame has retired.
+struct GpuScopeResult {
+    const char* name;   // string literal passed to beginScope
+    int32_t index;      // optional per-object index (-1 = none)
+    uint32_t depth;     // nesting level, results are in pre-order
+    double ms;
+};
+
+class GpuProfiler {
+public:
+    GpuProfiler(VulkanDevice& device, uint32_t framesInFlight, uint32_t maxScopesPerFrame = 256);
+    ~GpuProfiler();
+
+    // Reads the slot's previous results (if ready) - call after the slot's frame has retired.
+    // Returns true when new results were collected.
+    bool collect(uint32_t slot);
+    // Resets the slot's queries; must be recorded outside a render pass
+    void beginFrame(VkCommandBuffer cmd, uint32_t slot);
+    // Returns a scope id for endScope, or UINT32_MAX when the slice is full (scope dropped)
+    uint32_t beginScope(VkCommandBuffer cmd, const char* name, int32_t index = -1);
+    void endScope(VkCommandBuffer cmd, uint32_t scopeId);
+
+    bool isEnabled() const { return queryPool != VK_NULL_HANDLE; }
+    // Last collected frame: pre-order scope tree and the first-begin to last-end span
+    const std::vector<GpuScopeResult>& getResults() const { return results; }
+    double getFrameMs() const { return frameMs; }
+private:
+    struct ScopeRecord {
+        const char* name;
+        int32_t index;
+        uint32_t depth;
+    };
+    struct Slice {
+        std::vector<ScopeRecord> scopes;
+        bool pending = false; // written by a submitted frame, not read back yet
+    };
+    VkDevice device;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    uint32_t maxScopes;
+    double timestampPeriodNs = 1.0;
+    uint64_t timestampMask = ~0ull;
+    std::vector<Slice> slices;
+    uint32_t currentSlot = 0;
+    uint32_t currentDepth = 0;
+    std::vector<uint64_t> ticks;
+    std::vector<GpuScopeResult> results;
+    double frameMs = -1.0;
+};
+
+// RAII helper: GpuScope scope(profiler, cmd, "imgui");
+class GpuScope {
+public:
+    GpuScope(GpuProfiler* profiler, VkCommandBuffer cmd, const char* name, int32_t index = -1)
+        : profiler(profiler), cmd(cmd), id(profiler ? profiler->beginScope(cmd, name, index) : UINT32_MAX) {}
+    ~GpuScope() { if (profiler) profiler->endScope(cmd, id); }
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+private:
+    GpuProfiler* profiler;
+    VkCommandBuffer cmd;
+    uint32_t id;
+};
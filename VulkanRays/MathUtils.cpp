@@ -72,3 +72,17 @@ Mat4 mat4_mul(const Mat4& a, const Mat4& b) {
                 r.m[i + j*4] += a.m[i + k*4] * b.m[k + j*4];
     return r;
 }
+
+
+void frustumPlanes(const Mat4& m, float planes[6][4]) {
+    // Gribb/Hartmann: row 3 plus or minus rows 0-2. perspective() maps depth to [-w, w], so
+    // near is w + z; Vulkan only keeps [0, w], which makes this near plane a little loose.
+    for (int p = 0; p < 6; ++p) {
+        int row = p / 2;
+        float sign = (p % 2) ? -1.0f : 1.0f;
+        for (int c = 0; c < 4; ++c) planes[p][c] = m.m[c * 4 + 3] + sign * m.m[c * 4 + row];
+        float len = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (len > 0.0f)
+            for (int c = 0; c < 4; ++c) planes[p][c] /= len;
+    }
+}
\ No newline at end of file
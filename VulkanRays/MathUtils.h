@@ -11,3 +11,6 @@ Mat4 rotationX(float angle);
 Mat4 rotationY(float angle);
 Mat4 rotationZ(float angle);
 Mat4 mat4_mul(const Mat4& a, const Mat4& b);
+// Planes (a, b, c, d; inside where a*x + b*y + c*z + d >= 0, unit normals) bounding
+// clip = m * p, in the space m maps from: left, right, bottom, top, near, far
+void frustumPlanes(const Mat4& m, float planes[6][4]);
@@ -0,0 +1,528 @@
+#include "MemoryAllocator.h"
+#include <algorithm>
+#include <stdexcept>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+
+uint32_t mostSignificantBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (uint32_t)index;
+#else
+    return 63u - (uint32_t)__builtin_clzll(v);
+#endif
+}
+
+uint32_t leastSignificantBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(v);
+#endif
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1); // Vulkan alignments are powers of two
+}
+} // namespace
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device(device) {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    pools.resize(memoryProperties.memoryTypeCount * 2);
+    for (uint32_t i = 0; i < pools.size(); ++i) {
+        Pool& pool = pools[i];
+        pool.memoryType = i / 2;
+        // Small heaps (e.g. the 256 MiB host-visible device-local window) get smaller blocks
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[pool.memoryType].heapIndex].size;
+        pool.blockSize = std::min(DEFAULT_BLOCK_SIZE, alignUp(std::max<VkDeviceSize>(heapSize / 8, MIN_ALIGNMENT), MIN_ALIGNMENT));
+        for (auto& heads : pool.freeHeads) std::fill(std::begin(heads), std::end(heads), NONE);
+    }
+}
+
+MemoryAllocator::~MemoryAllocator() {
+    for (Block& block : blocks)
+        if (block.memory) vkFreeMemory(device, block.memory, nullptr); // also unmaps
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            return i;
+    }
+    throw std::runtime_error("Failed to find suitable memory type");
+}
+
+bool MemoryAllocator::hasMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            return true;
+    }
+    return false;
+}
+
+// Size class of a region: first level = power of two, second level = linear split of it.
+// Sizes below SL_COUNT all map to first level 0.
+void MemoryAllocator::mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl) {
+    if (size < SL_COUNT) {
+        fl = 0;
+        sl = (uint32_t)size;
+        return;
+    }
+    uint32_t msb = mostSignificantBit(size);
+    fl = msb - SL_LOG2 + 1;
+    sl = (uint32_t)(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+}
+
+uint32_t MemoryAllocator::findFree(const Pool& pool, VkDeviceSize size) const {
+    // Round up to the next class boundary so any region in the found list is big enough
+    if (size >= SL_COUNT) size += (1ull << (mostSignificantBit(size) - SL_LOG2)) - 1;
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    if (fl >= FL_COUNT) return NONE;
+    uint32_t slBits = pool.slBitmap[fl] & (~0u << sl);
+    if (!slBits) {
+        uint64_t flBits = fl + 1 < 64 ? pool.flBitmap & (~0ull << (fl + 1)) : 0;
+        if (!flBits) return NONE;
+        fl = leastSignificantBit(flBits);
+        slBits = pool.slBitmap[fl];
+    }
+    sl = leastSignificantBit(slBits);
+    return pool.freeHeads[fl][sl];
+}
+
+uint32_t MemoryAllocator::findFreeOutside(const Pool& pool, VkDeviceSize size, uint32_t avoidBlock) const {
+    // Walks the lists instead of trusting the list head, skipping regions in avoidBlock and
+    // (in the first class) regions that are too small
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    for (; fl < FL_COUNT; ++fl, sl = 0) {
+        uint32_t slBits = pool.slBitmap[fl] & (~0u << sl);
+        while (slBits) {
+            uint32_t s = leastSignificantBit(slBits);
+            slBits &= slBits - 1;
+            for (uint32_t i = pool.freeHeads[fl][s]; i != NONE; i = regions[i].nextFree)
+                if (regions[i].block != avoidBlock && regions[i].size >= size) return i;
+        }
+    }
+    return NONE;
+}
+
+void MemoryAllocator::insertFree(Pool& pool, uint32_t index) {
+    Region& r = regions[index];
+    uint32_t fl, sl;
+    mapping(r.size, fl, sl);
+    r.free = true;
+    r.prevFree = NONE;
+    r.nextFree = pool.freeHeads[fl][sl];
+    if (r.nextFree != NONE) regions[r.nextFree].prevFree = index;
+    pool.freeHeads[fl][sl] = index;
+    pool.slBitmap[fl] |= 1u << sl;
+    pool.flBitmap |= 1ull << fl;
+    pool.freeBytes += r.size;
+    ++freeRegionCount;
+}
+
+void MemoryAllocator::removeFree(Pool& pool, uint32_t index) {
+    Region& r = regions[index];
+    uint32_t fl, sl;
+    mapping(r.size, fl, sl);
+    if (r.prevFree != NONE) regions[r.prevFree].nextFree = r.nextFree;
+    else pool.freeHeads[fl][sl] = r.nextFree;
+    if (r.nextFree != NONE) regions[r.nextFree].prevFree = r.prevFree;
+    if (pool.freeHeads[fl][sl] == NONE) {
+        pool.slBitmap[fl] &= ~(1u << sl);
+        if (!pool.slBitmap[fl]) pool.flBitmap &= ~(1ull << fl);
+    }
+    r.free = false;
+    r.prevFree = r.nextFree = NONE;
+    pool.freeBytes -= r.size;
+    --freeRegionCount;
+}
+
+uint32_t MemoryAllocator::newRegion() {
+    if (!unusedRegions.empty()) {
+        uint32_t index = unusedRegions.back();
+        unusedRegions.pop_back();
+        regions[index] = Region{};
+        return index;
+    }
+    regions.emplace_back();
+    return (uint32_t)regions.size() - 1;
+}
+
+uint32_t MemoryAllocator::createBlock(uint32_t poolIndex, VkDeviceSize size, bool dedicated) {
+    Pool& pool = pools[poolIndex];
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = pool.memoryType;
+    Block block;
+    block.size = size;
+    block.pool = poolIndex;
+    block.dedicated = dedicated;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block.memory) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate device memory block");
+    if (memoryProperties.memoryTypes[pool.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, block.memory, nullptr);
+            throw std::runtime_error("Failed to map device memory block");
+        }
+    }
+    uint32_t index;
+    if (!unusedBlocks.empty()) {
+        index = unusedBlocks.back();
+        unusedBlocks.pop_back();
+        blocks[index] = block;
+    } else {
+        index = (uint32_t)blocks.size();
+        blocks.push_back(block);
+    }
+    if (!dedicated) ++pool.blockCount;
+    return index;
+}
+
+void MemoryAllocator::releaseBlock(uint32_t blockIndex, uint32_t region) {
+    Block& block = blocks[blockIndex];
+    if (!block.dedicated) --pools[block.pool].blockCount;
+    // Queued flushes into memory that's about to go away are moot
+    pendingFlushes.erase(std::remove_if(pendingFlushes.begin(), pendingFlushes.end(),
+                                        [&](const VkMappedMemoryRange& r) { return r.memory == block.memory; }),
+                         pendingFlushes.end());
+    vkFreeMemory(device, block.memory, nullptr);
+    block = Block{};
+    unusedBlocks.push_back(blockIndex);
+    regions[region].block = NONE;
+    unusedRegions.push_back(region);
+}
+
+const char* MemoryCategoryName(MemoryCategory category) {
+    switch (category) {
+    case MemoryCategory::Geometry: return "geometry";
+    case MemoryCategory::Uniforms: return "uniforms";
+    case MemoryCategory::RenderTargets: return "render targets";
+    case MemoryCategory::Staging: return "staging";
+    case MemoryCategory::UI: return "ui";
+    case MemoryCategory::Textures: return "textures";
+    default: return "other";
+    }
+}
+
+void MemoryAllocator::addUsage(MemoryCategory category, VkDeviceSize size) {
+    MemoryCategoryStats& stats = categoryStats[static_cast<uint32_t>(category)];
+    stats.bytes += size;
+    ++stats.count;
+    peakBytes = std::max(peakBytes, usedBytes + externalBytes);
+}
+
+void MemoryAllocator::removeUsage(MemoryCategory category, VkDeviceSize size) {
+    MemoryCategoryStats& stats = categoryStats[static_cast<uint32_t>(category)];
+    stats.bytes -= size;
+    --stats.count;
+}
+
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, AllocationKind kind,
+                                           MemoryCategory category) {
+    uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+    uint32_t poolIndex = memoryType * 2 + (kind == AllocationKind::Optimal ? 1 : 0);
+    VkDeviceSize alignment = std::max(requirements.alignment, MIN_ALIGNMENT);
+    VkDeviceSize size = alignUp(std::max<VkDeviceSize>(requirements.size, 1), MIN_ALIGNMENT);
+    std::lock_guard<std::mutex> lock(mutex);
+    Pool& pool = pools[poolIndex];
+    MemoryAllocation allocation;
+    allocation.memoryType = memoryType;
+    allocation.size = size;
+
+    if (size > pool.blockSize / 2) {
+        // Big resources (render targets at high resolutions) get their own memory object
+        uint32_t blockIndex = createBlock(poolIndex, size, true);
+        uint32_t index = newRegion();
+        Region& r = regions[index];
+        r.size = size;
+        r.block = blockIndex;
+        r.category = category;
+        allocation.memory = blocks[blockIndex].memory;
+        allocation.mapped = blocks[blockIndex].mapped;
+        allocation.region = index;
+        blocks[blockIndex].usedBytes = size;
+        ++allocationCount;
+        usedBytes += size;
+        addUsage(category, size);
+        return allocation;
+    }
+
+    // Alignments above MIN_ALIGNMENT may need padding in front; search for the worst case
+    VkDeviceSize searchSize = size + (alignment - MIN_ALIGNMENT);
+    uint32_t index = findFree(pool, searchSize);
+    if (index == NONE) {
+        uint32_t blockIndex = createBlock(poolIndex, pool.blockSize, false);
+        index = newRegion();
+        regions[index].size = pool.blockSize;
+        regions[index].block = blockIndex;
+        insertFree(pool, index);
+    }
+    return carve(pool, index, size, alignment, category);
+}
+
+MemoryAllocation MemoryAllocator::carve(Pool& pool, uint32_t index, VkDeviceSize size, VkDeviceSize alignment, MemoryCategory category) {
+    // Takes free region index, splits off alignment padding in front and the unused tail
+    removeFree(pool, index);
+    VkDeviceSize alignedOffset = alignUp(regions[index].offset, alignment);
+    VkDeviceSize padding = alignedOffset - regions[index].offset;
+    if (padding > 0) {
+        // Padding becomes its own free region (its physical predecessor is never free,
+        // as free neighbours are always merged)
+        uint32_t front = newRegion();
+        Region& r = regions[index];
+        Region& f = regions[front];
+        f.offset = r.offset;
+        f.size = padding;
+        f.block = r.block;
+        f.prevPhysical = r.prevPhysical;
+        f.nextPhysical = index;
+        if (r.prevPhysical != NONE) regions[r.prevPhysical].nextPhysical = front;
+        r.prevPhysical = front;
+        r.offset = alignedOffset;
+        r.size -= padding;
+        insertFree(pool, front);
+    }
+    if (regions[index].size - size >= MIN_ALIGNMENT) {
+        uint32_t tail = newRegion();
+        Region& r = regions[index];
+        Region& t = regions[tail];
+        t.offset = r.offset + size;
+        t.size = r.size - size;
+        t.block = r.block;
+        t.prevPhysical = index;
+        t.nextPhysical = r.nextPhysical;
+        if (r.nextPhysical != NONE) regions[r.nextPhysical].prevPhysical = tail;
+        r.nextPhysical = tail;
+        r.size = size;
+        insertFree(pool, tail);
+    }
+    const Region& r = regions[index];
+    Block& block = blocks[r.block];
+    MemoryAllocation allocation;
+    allocation.memoryType = pool.memoryType;
+    allocation.memory = block.memory;
+    allocation.offset = r.offset;
+    allocation.size = r.size;
+    allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + r.offset : nullptr;
+    allocation.region = index;
+    regions[index].category = category;
+    regions[index].owner = nullptr;
+    regions[index].moved = false;
+    block.usedBytes += r.size;
+    ++allocationCount;
+    usedBytes += r.size;
+    addUsage(category, r.size);
+    return allocation;
+}
+
+void MemoryAllocator::free(MemoryAllocation& allocation) {
+    if (allocation.region == NONE) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t index = allocation.region;
+    allocation = MemoryAllocation{};
+    uint32_t blockIndex = regions[index].block;
+    Block& block = blocks[blockIndex];
+    Pool& pool = pools[block.pool];
+    --allocationCount;
+    usedBytes -= regions[index].size;
+    block.usedBytes -= regions[index].size;
+    regions[index].owner = nullptr;
+    removeUsage(regions[index].category, regions[index].size);
+    if (block.dedicated) {
+        releaseBlock(blockIndex, index);
+        return;
+    }
+    // Merge with free neighbours so the free lists never hold two adjacent regions
+    uint32_t prev = regions[index].prevPhysical;
+    if (prev != NONE && regions[prev].free) {
+        removeFree(pool, prev);
+        regions[prev].size += regions[index].size;
+        regions[prev].nextPhysical = regions[index].nextPhysical;
+        if (regions[index].nextPhysical != NONE) regions[regions[index].nextPhysical].prevPhysical = prev;
+        regions[index].block = NONE;
+        unusedRegions.push_back(index);
+        index = prev;
+    }
+    uint32_t next = regions[index].nextPhysical;
+    if (next != NONE && regions[next].free) {
+        removeFree(pool, next);
+        regions[index].size += regions[next].size;
+        regions[index].nextPhysical = regions[next].nextPhysical;
+        if (regions[next].nextPhysical != NONE) regions[regions[next].nextPhysical].prevPhysical = index;
+        regions[next].block = NONE;
+        unusedRegions.push_back(next);
+    }
+    // Keep one empty block per pool around so create/destroy cycles don't hit the driver
+    if (regions[index].size == block.size && pool.blockCount > 1) {
+        releaseBlock(blockIndex, index);
+        return;
+    }
+    insertFree(pool, index);
+}
+
+bool MemoryAllocator::isCoherent(const MemoryAllocation& allocation) const {
+    return (memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+VkMappedMemoryRange MemoryAllocator::mappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const {
+    // Ranges must start and end on nonCoherentAtomSize (or end at the end of the memory object);
+    // the extra bytes belong to neighbours and flushing them is harmless
+    VkDeviceSize blockSize = blocks[regions[allocation.region].block].size;
+    VkDeviceSize begin = (allocation.offset + offset) / nonCoherentAtomSize * nonCoherentAtomSize;
+    VkDeviceSize end = std::min(alignUp(allocation.offset + offset + size, nonCoherentAtomSize), blockSize);
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = allocation.memory;
+    range.offset = begin;
+    range.size = end - begin;
+    return range;
+}
+
+void MemoryAllocator::flushRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (allocation.region == NONE || size == 0 || isCoherent(allocation)) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingFlushes.push_back(mappedRange(allocation, offset, size));
+}
+
+void MemoryAllocator::flushPending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingFlushes.empty()) return;
+    if (vkFlushMappedMemoryRanges(device, (uint32_t)pendingFlushes.size(), pendingFlushes.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to flush mapped memory ranges");
+    pendingFlushes.clear();
+}
+
+void MemoryAllocator::invalidateRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (allocation.region == NONE || size == 0 || isCoherent(allocation)) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    VkMappedMemoryRange range = mappedRange(allocation, offset, size);
+    if (vkInvalidateMappedMemoryRanges(device, 1, &range) != VK_SUCCESS)
+        throw std::runtime_error("Failed to invalidate mapped memory range");
+}
+
+MemoryStats MemoryAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryStats stats;
+    for (const Block& block : blocks) {
+        if (!block.memory) continue;
+        ++stats.blockCount;
+        if (block.dedicated) ++stats.dedicatedCount;
+        stats.blockBytes += block.size;
+    }
+    stats.allocationCount = allocationCount;
+    stats.usedBytes = usedBytes;
+    stats.freeRegionCount = freeRegionCount;
+    VkDeviceSize freeBytes = 0, outsideLargest = 0;
+    for (const Pool& pool : pools) {
+        if (!pool.flBitmap) continue;
+        // The largest region sits in the highest non-empty size class
+        uint32_t fl = mostSignificantBit(pool.flBitmap);
+        uint32_t sl = mostSignificantBit(pool.slBitmap[fl]);
+        VkDeviceSize largest = 0;
+        for (uint32_t i = pool.freeHeads[fl][sl]; i != NONE; i = regions[i].nextFree)
+            largest = std::max(largest, regions[i].size);
+        stats.largestFreeRegion = std::max(stats.largestFreeRegion, largest);
+        freeBytes += pool.freeBytes;
+        outsideLargest += pool.freeBytes - largest;
+    }
+    stats.fragmentation = freeBytes ? (double)outsideLargest / (double)freeBytes : 0.0;
+    for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) stats.categories[i] = categoryStats[i];
+    stats.externalBytes = externalBytes;
+    stats.peakBytes = peakBytes;
+    for (const Block& block : blocks)
+        if (block.memory && !block.dedicated && block.usedBytes < block.size / 2) ++stats.sparseBlockCount;
+    return stats;
+}
+
+// --- Defragmentation support ---
+void MemoryAllocator::setOwner(const MemoryAllocation& allocation, void* owner) {
+    if (allocation.region == NONE) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    regions[allocation.region].owner = owner;
+}
+
+void MemoryAllocator::markMoved(const MemoryAllocation& allocation) {
+    if (allocation.region == NONE) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    regions[allocation.region].owner = nullptr;
+    regions[allocation.region].moved = true;
+}
+
+uint32_t MemoryAllocator::getBlockIndex(const MemoryAllocation& allocation) const {
+    if (allocation.region == NONE) return NONE;
+    std::lock_guard<std::mutex> lock(mutex);
+    return regions[allocation.region].block;
+}
+
+uint32_t MemoryAllocator::findDefragBlock(double maxOccupancy, std::vector<void*>& owners) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    owners.clear();
+    // Live bytes per block (copies already moved out don't count); a single allocation
+    // without an owner pins its block
+    defragLiveBytes.assign(blocks.size(), 0);
+    defragPinned.assign(blocks.size(), 0);
+    for (const Region& r : regions) {
+        if (r.block == NONE || r.free || r.moved) continue;
+        if (r.owner) defragLiveBytes[r.block] += r.size;
+        else defragPinned[r.block] = 1;
+    }
+    uint32_t best = NONE;
+    for (uint32_t b = 0; b < blocks.size(); ++b) {
+        const Block& block = blocks[b];
+        VkDeviceSize live = defragLiveBytes[b];
+        if (!block.memory || block.dedicated || defragPinned[b] || live == 0) continue;
+        if ((double)live > maxOccupancy * (double)block.size) continue;
+        // The rest of the pool needs room for everything that's still live here
+        const Pool& pool = pools[block.pool];
+        if (pool.blockCount < 2 || pool.freeBytes - (block.size - block.usedBytes) < live) continue;
+        if (best == NONE || live < defragLiveBytes[best]) best = b;
+    }
+    if (best == NONE) return NONE;
+    for (const Region& r : regions)
+        if (r.block == best && !r.free && !r.moved && r.owner) owners.push_back(r.owner);
+    return best;
+}
+
+MemoryAllocation MemoryAllocator::allocateForMove(const MemoryAllocation& source, const VkMemoryRequirements& requirements, uint32_t avoidBlock) {
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryCategory category = regions[source.region].category;
+    Pool& pool = pools[blocks[regions[source.region].block].pool];
+    if (!(requirements.memoryTypeBits & (1u << pool.memoryType))) return MemoryAllocation{};
+    VkDeviceSize alignment = std::max(requirements.alignment, MIN_ALIGNMENT);
+    VkDeviceSize size = alignUp(std::max<VkDeviceSize>(requirements.size, 1), MIN_ALIGNMENT);
+    uint32_t index = findFreeOutside(pool, size + (alignment - MIN_ALIGNMENT), avoidBlock);
+    if (index == NONE) return MemoryAllocation{};
+    return carve(pool, index, size, alignment, category);
+}
+
+void MemoryAllocator::trackExternal(VkDeviceMemory memory, VkDeviceSize size, MemoryCategory category) {
+    std::lock_guard<std::mutex> lock(mutex);
+    externalAllocations.push_back({ memory, size, category });
+    externalBytes += size;
+    addUsage(category, size);
+}
+
+void MemoryAllocator::untrackExternal(VkDeviceMemory memory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < externalAllocations.size(); ++i) {
+        if (externalAllocations[i].memory != memory) continue;
+        externalBytes -= externalAllocations[i].size;
+        removeUsage(externalAllocations[i].category, externalAllocations[i].size);
+        externalAllocations[i] = externalAllocations.back();
+        externalAllocations.pop_back();
+        return;
+    }
+}
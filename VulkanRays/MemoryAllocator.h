@@ -0,0 +1,170 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// --- MemoryAllocator: sub-allocates large VkDeviceMemory blocks ---
+// One pool per (memory type, resource kind). Each pool carves its blocks into regions kept
+// in a two-level segregated free list (TLSF): a bitmap lookup finds a free region of the
+// right size class in O(1), and freed regions merge with free neighbours straight away.
+// Buffers and optimal-tiling images live in separate pools, so they never share a
+// bufferImageGranularity page. Host-visible blocks are mapped once for their lifetime;
+// writes to non-coherent ones are queued with flushRange and flushed together once a frame.
+// Requests larger than half a block get a dedicated VkDeviceMemory.
+
+// What an allocation is for. Usage is tracked per category, including memory allocated
+// outside the allocator (e.g. by the ImGui backend) and reported with trackExternal().
+enum class MemoryCategory : uint32_t { Geometry, Uniforms, RenderTargets, Staging, UI, Textures, Other, Count };
+constexpr uint32_t MEMORY_CATEGORY_COUNT = static_cast<uint32_t>(MemoryCategory::Count);
+const char* MemoryCategoryName(MemoryCategory category);
+
+struct MemoryCategoryStats {
+    VkDeviceSize bytes = 0;
+    uint32_t count = 0;
+};
+
+struct MemoryAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;   // host pointer at offset (host-visible memory only)
+    uint32_t memoryType = 0;
+    uint32_t region = UINT32_MAX; // internal handle, UINT32_MAX = nothing allocated
+};
+
+enum class AllocationKind { Linear, Optimal }; // buffers (and linear images) vs optimal-tiling images
+
+struct MemoryStats {
+    uint32_t blockCount = 0;        // VkDeviceMemory objects, dedicated ones included
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize blockBytes = 0;    // requested from the driver
+    VkDeviceSize usedBytes = 0;     // handed out to resources
+    uint32_t freeRegionCount = 0;
+    VkDeviceSize largestFreeRegion = 0;
+    // Share of free bytes outside the largest free region of their pool (0 = no fragmentation)
+    double fragmentation = 0.0;
+    MemoryCategoryStats categories[MEMORY_CATEGORY_COUNT]; // allocator + external allocations
+    VkDeviceSize externalBytes = 0;  // allocated outside the allocator (trackExternal)
+    VkDeviceSize peakBytes = 0;      // highest usedBytes + externalBytes so far
+    uint32_t sparseBlockCount = 0;   // shared blocks less than half used (defragmentation candidates)
+};
+
+class MemoryAllocator {
+public:
+    MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+    ~MemoryAllocator(); // releases every block; resources using them must be gone by then
+
+    // Throws std::runtime_error when no memory type matches or the driver is out of memory
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, AllocationKind kind,
+                              MemoryCategory category = MemoryCategory::Other);
+    void free(MemoryAllocation& allocation); // resets allocation; no-op when empty
+    MemoryStats getStats() const;
+    // Accounting for VkDeviceMemory allocated elsewhere; untrack is a no-op for unknown memory
+    void trackExternal(VkDeviceMemory memory, VkDeviceSize size, MemoryCategory category);
+    void untrackExternal(VkDeviceMemory memory);
+    // Whether allocate() can satisfy these requirements (e.g. probing for LAZILY_ALLOCATED)
+    bool hasMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+    // --- Defragmentation support (see Defragmenter) ---
+    // owner: what to move when the allocation's block is emptied (a VulkanBuffer);
+    // allocations without an owner pin their block
+    void setOwner(const MemoryAllocation& allocation, void* owner);
+    // The allocation's contents were copied elsewhere and it is waiting to be freed: it
+    // neither pins its block nor gets moved again
+    void markMoved(const MemoryAllocation& allocation);
+    // Least occupied shared block below maxOccupancy whose allocations all have owners and
+    // fit into the free space of the pool's other blocks. Returns NONE if there is none.
+    uint32_t findDefragBlock(double maxOccupancy, std::vector<void*>& owners) const;
+    uint32_t getBlockIndex(const MemoryAllocation& allocation) const;
+    // Same memory type, kind and category as source, but only in existing blocks other than
+    // avoidBlock. Returns an empty allocation (region == UINT32_MAX) when nothing fits.
+    MemoryAllocation allocateForMove(const MemoryAllocation& source, const VkMemoryRequirements& requirements, uint32_t avoidBlock);
+
+    bool isCoherent(const MemoryAllocation& allocation) const;
+    // Queue a host-written range of a mapped allocation for flushing (no-op for coherent memory)
+    void flushRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+    // One vkFlushMappedMemoryRanges for everything queued; call before submitting work that reads it
+    void flushPending();
+    // Make device writes visible to the host before reading (no-op for coherent memory)
+    void invalidateRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+
+    MemoryAllocator(const MemoryAllocator&) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+private:
+    static constexpr uint32_t SL_LOG2 = 4;                 // 16 size classes per power of two
+    static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+private:
+    static constexpr VkDeviceSize MIN_ALIGNMENT = 16;      // region offsets/sizes are multiples of this
+
+    struct Region {
+        VkDeviceSize offset = 0, size = 0;
+        uint32_t block = NONE;
+        uint32_t prevPhysical = NONE, nextPhysical = NONE; // neighbours inside the block
+        uint32_t prevFree = NONE, nextFree = NONE;         // size-class list (free regions only)
+        bool free = false;
+        MemoryCategory category = MemoryCategory::Other; // allocated regions only
+        void* owner = nullptr;                            // allocated regions only
+        bool moved = false;                               // see markMoved
+    };
+    struct ExternalAllocation {
+        VkDeviceMemory memory;
+        VkDeviceSize size;
+        MemoryCategory category;
+    };
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        uint32_t pool = NONE;
+        bool dedicated = false;
+        VkDeviceSize usedBytes = 0;
+    };
+    struct Pool {
+        uint32_t memoryType = 0;
+        VkDeviceSize blockSize = 0;
+        uint32_t blockCount = 0;   // non-dedicated blocks
+        uint64_t flBitmap = 0;     // bit f: some list in first level f is non-empty
+        uint32_t slBitmap[FL_COUNT] = {};
+        uint32_t freeHeads[FL_COUNT][SL_COUNT];
+        VkDeviceSize freeBytes = 0;
+    };
+
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    VkDeviceSize nonCoherentAtomSize = 1;
+    std::vector<VkMappedMemoryRange> pendingFlushes;
+    mutable std::mutex mutex;
+    std::vector<Pool> pools;          // memoryType * 2 + kind
+    std::vector<Region> regions;
+    std::vector<uint32_t> unusedRegions;
+    std::vector<Block> blocks;
+    std::vector<uint32_t> unusedBlocks;
+    uint32_t allocationCount = 0;
+    VkDeviceSize usedBytes = 0;
+    uint32_t freeRegionCount = 0;
+    MemoryCategoryStats categoryStats[MEMORY_CATEGORY_COUNT];
+    std::vector<ExternalAllocation> externalAllocations;
+    VkDeviceSize externalBytes = 0;
+    VkDeviceSize peakBytes = 0;
+    mutable std::vector<VkDeviceSize> defragLiveBytes; // findDefragBlock scratch, per block
+    mutable std::vector<uint8_t> defragPinned;
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+    uint32_t createBlock(uint32_t poolIndex, VkDeviceSize size, bool dedicated);
+    void releaseBlock(uint32_t blockIndex, uint32_t region);
+    uint32_t newRegion();
+    void addUsage(MemoryCategory category, VkDeviceSize size);
+    void removeUsage(MemoryCategory category, VkDeviceSize size);
+    VkMappedMemoryRange mappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+    void insertFree(Pool& pool, uint32_t index);
+    void removeFree(Pool& pool, uint32_t index);
+    uint32_t findFree(const Pool& pool, VkDeviceSize size) const;
+    uint32_t findFreeOutside(const Pool& pool, VkDeviceSize size, uint32_t avoidBlock) const;
+    MemoryAllocation carve(Pool& pool, uint32_t index, VkDeviceSize size, VkDeviceSize alignment, MemoryCategory category);
+    static void mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl);
+};
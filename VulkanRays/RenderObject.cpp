@@ -1,10 +1,11 @@
 #include "RenderObject.h"
+#include <algorithm>
 #include <cstring>
 #include <vector>
 #include <cmath>
 
 // --- RenderObject transform implementation ---
-Mat4 RenderObject::getModelMatrix() const {
+static Mat4 composeModelMatrix(const float position[3], const float rotation[3], const float scale[3]) {
     // Compose scale, then rotation (Z, Y, X), then translation
     Mat4 S = {};
     for (int i = 0; i < 16; ++i) S.m[i] = 0.0f;
@@ -22,54 +23,140 @@ Mat4 RenderObject::getModelMatrix() const {
     return M;
 }
 
+Mat4 RenderObject::getModelMatrix() const {
+    return composeModelMatrix(position, rotation, scale);
+}
+
+void RenderObject::storePreviousTransform() {
+    std::memcpy(prevPosition, position, sizeof(position));
+    std::memcpy(prevRotation, rotation, sizeof(rotation));
+    std::memcpy(prevScale, scale, sizeof(scale));
+}
+
+Mat4 RenderObject::getInterpolatedModelMatrix(float alpha) const {
+    float p[3], r[3], s[3];
+    for (int i = 0; i < 3; ++i) {
+        p[i] = prevPosition[i] + (position[i] - prevPosition[i]) * alpha;
+        // Shortest way round, so an angle wrapped to [-pi, pi] doesn't spin backwards for a frame
+        float dr = std::remainder(rotation[i] - prevRotation[i], 6.2831853f);
+        r[i] = prevRotation[i] + dr * alpha;
+        s[i] = prevScale[i] + (scale[i] - prevScale[i]) * alpha;
+    }
+    return composeModelMatrix(p, r, s);
+}
+
+void RenderObject::drawIndexed(VkCommandBuffer cmd, const DrawBinding& binding, uint32_t indexCount, uint32_t instanceCount) {
+    if (binding.descriptorSet)
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, binding.layout, 0, 1, &binding.descriptorSet, 1, &binding.uniformOffset);
+    if (binding.pushMvp)
+        vkCmdPushConstants(cmd, binding.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Mat4), binding.pushMvp);
+    if (binding.indirectCount)
+        vkCmdDrawIndexedIndirectCount(cmd, binding.indirectBuffer, binding.indirectOffset, binding.indirectCount, binding.countOffset,
+                                      binding.maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    else if (binding.indirectBuffer)
+        vkCmdDrawIndexedIndirect(cmd, binding.indirectBuffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+    else
+        vkCmdDrawIndexed(cmd, indexCount, instanceCount, 0, 0, binding.firstInstance);
+}
+
+void RenderObject::bindMesh(VkCommandBuffer cmd, const DrawBinding& binding, const MeshBuffers& mesh) {
+    if (binding.bindVertexBuffers) {
+        VkDeviceSize offsets[] = { 0, 0 };
+        vkCmdBindVertexBuffers(cmd, 0, mesh.vertex[1] ? 2 : 1, mesh.vertex, offsets);
+    }
+    if (binding.bindIndexBuffer) vkCmdBindIndexBuffer(cmd, mesh.index, 0, VK_INDEX_TYPE_UINT16);
+}
+
+void RenderObject::computeBounds(const std::vector<Vertex>& vertices, float bounds[4]) {
+    if (vertices.empty()) return;
+    float lo[3], hi[3];
+    for (int a = 0; a < 3; ++a) lo[a] = hi[a] = vertices[0].pos[a];
+    for (const Vertex& v : vertices)
+        for (int a = 0; a < 3; ++a) { lo[a] = std::min(lo[a], v.pos[a]); hi[a] = std::max(hi[a], v.pos[a]); }
+    for (int a = 0; a < 3; ++a) bounds[a] = 0.5f * (lo[a] + hi[a]);
+    float radius2 = 0.0f;
+    for (const Vertex& v : vertices) {
+        float dx = v.pos[0] - bounds[0], dy = v.pos[1] - bounds[1], dz = v.pos[2] - bounds[2];
+        radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+    }
+    bounds[3] = std::sqrt(radius2);
+}
+
 // Explicit member definitions for PyramidObject
-PyramidObject::PyramidObject()
-    : vertexBuffer(nullptr), indexBuffer(nullptr), indexCount(0) {}
+std::weak_ptr<PyramidObject::SharedMesh> PyramidObject::sharedMesh;
+
+PyramidObject::PyramidObject() = default;
 PyramidObject::~PyramidObject() = default;
 
-void PyramidObject::createBuffers(VulkanDevice& device, VkPhysicalDevice physicalDevice) {
+void PyramidObject::buildMesh(std::vector<Vertex>& vertices, std::vector<uint16_t>& indices) {
     float s = 1.0f;
-    Vertex vertices[5] = {
+    vertices = {
         {{-0.5f * s, 0.0f, -0.5f * s}, {1.0f, 0.0f, 0.0f}},
         {{ 0.5f * s, 0.0f, -0.5f * s}, {0.0f, 1.0f, 0.0f}},
         {{ 0.5f * s, 0.0f,  0.5f * s}, {0.0f, 0.0f, 1.0f}},
         {{-0.5f * s, 0.0f,  0.5f * s}, {1.0f, 1.0f, 0.0f}},
         {{ 0.0f, -1.0f * s,  0.0f}, {1.0f, 1.0f, 1.0f}}
     };
-    uint16_t indices[] = {
+    indices = {
         0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4, 0, 2, 1, 0, 3, 2
     };
-    indexCount = sizeof(indices) / sizeof(indices[0]);
-    VkDeviceSize vsize = sizeof(vertices);
-    VkDeviceSize isize = sizeof(indices);
-    vertexBuffer = std::make_unique<VulkanBuffer>(
-        device, physicalDevice, vsize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
-    vertexBuffer->uploadData(vertices, vsize);
-    indexBuffer = std::make_unique<VulkanBuffer>(
-        device, physicalDevice, isize,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
-    indexBuffer->uploadData(indices, isize);
 }
 
-void PyramidObject::recordDraw(VkCommandBuffer cmd, VkPipelineLayout layout, VkDescriptorSet descriptorSet) {
-    VkBuffer vbufs[] = { vertexBuffer->getBuffer() };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(cmd, 0, 1, vbufs, offsets);
-    vkCmdBindIndexBuffer(cmd, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &descriptorSet, 0, nullptr);
-    vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, 0);
+uint64_t PyramidObject::createBuffers(UploadService& uploads, DeletionQueue& buffers) {
+    mesh = sharedMesh.lock();
+    if (!mesh) {
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        buildMesh(vertices, indices);
+        mesh = std::make_shared<SharedMesh>();
+        mesh->indexCount = static_cast<uint32_t>(indices.size());
+        computeBounds(vertices, mesh->bounds);
+        VkDeviceSize vsize = sizeof(Vertex) * vertices.size();
+        VkDeviceSize isize = sizeof(uint16_t) * indices.size();
+        mesh->vertexBuffer = buffers.acquireBuffer(
+            vsize,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
+        );
+        uint64_t vertexUpload = uploads.upload(*mesh->vertexBuffer, 0, vertices.data(), vsize);
+        mesh->indexBuffer = buffers.acquireBuffer(
+            isize,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
+        );
+        mesh->upload = std::max(vertexUpload, uploads.upload(*mesh->indexBuffer, 0, indices.data(), isize));
+        sharedMesh = mesh;
+    }
+    std::memcpy(bounds, mesh->bounds, sizeof(bounds));
+    return mesh->upload;
+}
+
+void PyramidObject::releaseBuffers(DeletionQueue& buffers) {
+    // Only the last pyramid gives the buffers back; the others just drop their reference
+    if (mesh && mesh.use_count() == 1) {
+        buffers.release(std::move(mesh->vertexBuffer));
+        buffers.release(std::move(mesh->indexBuffer));
+    }
+    mesh.reset();
+}
+
+MeshBuffers PyramidObject::getMeshBuffers() const {
+    MeshBuffers buffers;
+    buffers.vertex[0] = mesh->vertexBuffer->getBuffer();
+    buffers.index = mesh->indexBuffer->getBuffer();
+    return buffers;
+}
+
+void PyramidObject::recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) {
+    bindMesh(cmd, binding, getMeshBuffers());
+    drawIndexed(cmd, binding, mesh->indexCount);
 }
 
 GridObject::GridObject(int gridSize_, float gridSpacing_)
     : gridSize(gridSize_), gridSpacing(gridSpacing_) {}
 GridObject::~GridObject() = default;
 
-void GridObject::createBuffers(VulkanDevice& device, VkPhysicalDevice physicalDevice) {
+uint64_t GridObject::createBuffers(UploadService& uploads, DeletionQueue& buffers) {
     constexpr float gridY = -0.001f;
     std::vector<Vertex> gridVertices;
     std::vector<uint16_t> gridIndices;
@@ -92,27 +179,246 @@ void GridObject::createBuffers(VulkanDevice& device, VkPhysicalDevice physicalDe
         gridIndices.push_back(idx - 1);
     }
     indexCount = static_cast<uint32_t>(gridIndices.size());
+    computeBounds(gridVertices, bounds);
     VkDeviceSize vsize = sizeof(Vertex) * gridVertices.size();
     VkDeviceSize isize = sizeof(uint16_t) * gridIndices.size();
-    vertexBuffer = std::make_unique<VulkanBuffer>(
-        device, physicalDevice, vsize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    vertexBuffer = buffers.acquireBuffer(
+        vsize,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
     );
-    vertexBuffer->uploadData(gridVertices.data(), vsize);
-    indexBuffer = std::make_unique<VulkanBuffer>(
-        device, physicalDevice, isize,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    uint64_t vertexUpload = uploads.upload(*vertexBuffer, 0, gridVertices.data(), vsize);
+    indexBuffer = buffers.acquireBuffer(
+        isize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
     );
-    indexBuffer->uploadData(gridIndices.data(), isize);
+    return std::max(vertexUpload, uploads.upload(*indexBuffer, 0, gridIndices.data(), isize));
+}
+
+void GridObject::releaseBuffers(DeletionQueue& buffers) {
+    buffers.release(std::move(vertexBuffer));
+    buffers.release(std::move(indexBuffer));
+}
+
+MeshBuffers GridObject::getMeshBuffers() const {
+    MeshBuffers mesh;
+    mesh.vertex[0] = vertexBuffer->getBuffer();
+    mesh.index = indexBuffer->getBuffer();
+    return mesh;
+}
+
+void GridObject::recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) {
+    bindMesh(cmd, binding, getMeshBuffers());
+    drawIndexed(cmd, binding, indexCount);
 }
 
-void GridObject::recordDraw(VkCommandBuffer cmd, VkPipelineLayout layout, VkDescriptorSet descriptorSet) {
-    VkBuffer vbufs[] = { vertexBuffer->getBuffer() };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(cmd, 0, 1, vbufs, offsets);
-    vkCmdBindIndexBuffer(cmd, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &descriptorSet, 0, nullptr);
-    vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, 0);
+
+// --- InstancedMeshObject ---
+InstancedMeshObject::InstancedMeshObject(std::vector<Vertex> vertices_, std::vector<uint16_t> indices_, uint32_t frameCount)
+    : vertices(std::move(vertices_)), indices(std::move(indices_)), staging(frameCount) {
+    computeBounds(vertices, bounds);
 }
+InstancedMeshObject::~InstancedMeshObject() = default;
+
+InstanceData InstancedMeshObject::makeInstance(const float position[3], float yaw, float scale, const float color[3]) {
+    const float rotation[3] = { 0.0f, yaw, 0.0f };
+    const float scales[3] = { scale, scale, scale };
+    Mat4 M = composeModelMatrix(position, rotation, scales);
+    InstanceData instance;
+    // Mat4 is column-major: row r is m[r], m[4 + r], m[8 + r], m[12 + r]
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 4; ++c) instance.model[r][c] = M.m[c * 4 + r];
+    instance.color[0] = color[0];
+    instance.color[1] = color[1];
+    instance.color[2] = color[2];
+    instance.color[3] = 1.0f;
+    return instance;
+}
+
+uint32_t InstancedMeshObject::addInstance(const InstanceData& instance) {
+    uint32_t handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        handle = (uint32_t)slotOfHandle.size();
+        slotOfHandle.push_back(0);
+    }
+    uint32_t slot = (uint32_t)instances.size();
+    instances.push_back(instance);
+    handleOfSlot.push_back(handle);
+    slotOfHandle[handle] = slot;
+    markDirty(slot);
+    return handle;
+}
+
+void InstancedMeshObject::removeInstance(uint32_t handle) {
+    uint32_t slot = slotOfHandle[handle];
+    uint32_t last = (uint32_t)instances.size() - 1;
+    if (slot != last) {
+        instances[slot] = instances[last];
+        handleOfSlot[slot] = handleOfSlot[last];
+        slotOfHandle[handleOfSlot[slot]] = slot;
+        markDirty(slot);
+    }
+    instances.pop_back();
+    handleOfSlot.pop_back();
+    slotOfHandle[handle] = UINT32_MAX;
+    freeHandles.push_back(handle);
+}
+
+void InstancedMeshObject::updateInstance(uint32_t handle, const InstanceData& instance) {
+    uint32_t slot = slotOfHandle[handle];
+    instances[slot] = instance;
+    markDirty(slot);
+}
+
+void InstancedMeshObject::markDirty(uint32_t slot) {
+    // Before createBuffers() everything goes up in the initial upload anyway
+    if (!instanceBuffer) return;
+    if (slot >= dirtyFlags.size()) dirtyFlags.resize(std::max<size_t>(slot + 1, dirtyFlags.size() * 2), 0);
+    if (dirtyFlags[slot]) return;
+    dirtyFlags[slot] = 1;
+    dirtySlots.push_back(slot);
+}
+
+uint64_t InstancedMeshObject::createBuffers(UploadService& uploads, DeletionQueue& buffers) {
+    VkDeviceSize vsize = sizeof(Vertex) * vertices.size();
+    VkDeviceSize isize = sizeof(uint16_t) * indices.size();
+    vertexBuffer = buffers.acquireBuffer(
+        vsize,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
+    );
+    uint64_t upload = uploads.upload(*vertexBuffer, 0, vertices.data(), vsize);
+    indexBuffer = buffers.acquireBuffer(
+        isize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
+    );
+    upload = std::max(upload, uploads.upload(*indexBuffer, 0, indices.data(), isize));
+    // Transfer source too: growing copies the old contents on the GPU
+    capacity = std::max<uint32_t>((uint32_t)instances.size(), MIN_CAPACITY);
+    instanceBuffer = buffers.acquireBuffer(
+        (VkDeviceSize)capacity * sizeof(InstanceData),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
+    );
+    initialUpload = uploads.upload(*instanceBuffer, 0, instances.data(), sizeof(InstanceData) * instances.size());
+    gpuCount = (uint32_t)instances.size();
+    dirtySlots.clear();
+    dirtyFlags.assign(instances.size(), 0);
+    return std::max(upload, initialUpload);
+}
+
+void InstancedMeshObject::releaseBuffers(DeletionQueue& buffers) {
+    buffers.release(std::move(vertexBuffer));
+    buffers.release(std::move(indexBuffer));
+    buffers.release(std::move(instanceBuffer));
+    for (auto& buffer : staging) buffers.release(std::move(buffer));
+}
+
+void InstancedMeshObject::grow(VkCommandBuffer cmd, uint32_t count, DeletionQueue& buffers) {
+    // Double, so a run of adds only grows a handful of times
+    capacity = std::max(count, capacity * 2);
+    std::unique_ptr<VulkanBuffer> grown = buffers.acquireBuffer(
+        (VkDeviceSize)capacity * sizeof(InstanceData),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, true
+    );
+    if (gpuCount) {
+        VkBufferCopy copy{ 0, 0, (VkDeviceSize)gpuCount * sizeof(InstanceData) };
+        vkCmdCopyBuffer(cmd, instanceBuffer->getBuffer(), grown->getBuffer(), 1, &copy);
+        // The dirty ranges copied next may overlap what was just copied
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    // Frames in flight still draw from the old buffer
+    buffers.release(std::move(instanceBuffer));
+    instanceBuffer = std::move(grown);
+}
+
+void InstancedMeshObject::recordUpdates(VkCommandBuffer cmd, uint32_t frameSlot, const UploadService& uploads, DeletionQueue& buffers) {
+    frameBytes = 0;
+    frameRanges = 0;
+    uint32_t count = (uint32_t)instances.size();
+    if (!instanceBuffer || (dirtySlots.empty() && count == gpuCount)) return;
+    // Don't race the transfer queue's initial fill; the changes wait a frame or two
+    if (!uploads.isComplete(initialUpload)) return;
+
+    // Dirty slots past the end were removed; the rest become ranges of adjacent slots.
+    // Past half the instances, one range over everything is cheaper than sorting.
+    regions.clear();
+    if (dirtySlots.size() > count / 2) {
+        if (count) regions.push_back({ 0, 0, (VkDeviceSize)count * sizeof(InstanceData) });
+        for (uint32_t slot : dirtySlots) dirtyFlags[slot] = 0;
+    } else {
+        std::sort(dirtySlots.begin(), dirtySlots.end());
+        for (uint32_t slot : dirtySlots) {
+            dirtyFlags[slot] = 0;
+            if (slot >= count) continue;
+            VkDeviceSize offset = (VkDeviceSize)slot * sizeof(InstanceData);
+            if (!regions.empty() && regions.back().dstOffset + regions.back().size == offset)
+                regions.back().size += sizeof(InstanceData);
+            else
+                regions.push_back({ 0, offset, sizeof(InstanceData) });
+        }
+    }
+    dirtySlots.clear();
+
+    // Stage the ranges back to back in this slot's buffer; the frame that last used it has retired
+    VkDeviceSize stagingBytes = 0;
+    for (VkBufferCopy& region : regions) {
+        region.srcOffset = stagingBytes;
+        stagingBytes += region.size;
+    }
+    std::unique_ptr<VulkanBuffer>& stage = staging[frameSlot];
+    if (stagingBytes && (!stage || stage->getSize() < stagingBytes)) {
+        buffers.release(std::move(stage));
+        stage = buffers.acquireBuffer(stagingBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                      MemoryCategory::Staging);
+    }
+    char* mapped = static_cast<char*>(stagingBytes ? stage->getMappedData() : nullptr);
+    for (const VkBufferCopy& region : regions)
+        std::memcpy(mapped + region.srcOffset, reinterpret_cast<const char*>(instances.data()) + region.dstOffset, (size_t)region.size);
+    if (stagingBytes) stage->markWritten(0, stagingBytes); // flushed with the rest of the frame
+
+    // Earlier frames (same queue) may still read the buffer as vertex input, and a defrag
+    // move may have just written it
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    if (count > capacity) grow(cmd, count, buffers);
+    if (!regions.empty())
+        vkCmdCopyBuffer(cmd, stage->getBuffer(), instanceBuffer->getBuffer(), (uint32_t)regions.size(), regions.data());
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    gpuCount = count;
+    frameBytes = stagingBytes;
+    frameRanges = (uint32_t)regions.size();
+}
+
+MeshBuffers InstancedMeshObject::getMeshBuffers() const {
+    MeshBuffers mesh;
+    mesh.vertex[0] = vertexBuffer->getBuffer();
+    mesh.vertex[1] = instanceBuffer->getBuffer();
+    mesh.index = indexBuffer->getBuffer();
+    return mesh;
+}
+
+void InstancedMeshObject::recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) {
+    // Bound even without instances, so the draw list's idea of what is bound stays right
+    MeshBuffers mesh = getMeshBuffers();
+    if (binding.indirectInstances) mesh.vertex[1] = binding.indirectInstances; // culled on the GPU
+    bindMesh(cmd, binding, mesh);
+    if (gpuCount == 0) return;
+    drawIndexed(cmd, binding, (uint32_t)indices.size(), gpuCount);
+}
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <memory>
+#include <cstring>
 #include "VulkanBuffer.h"
+#include "UploadService.h"
+#include "DeletionQueue.h"
 #include "VulkanPipeline.h"
 #include "MathUtils.h"
 #include <vector>
@@ -12,20 +15,57 @@ struct Vertex {
     float color[3];
 };
 
+// Where a draw's MVP comes from (see DrawPath)
+struct DrawBinding {
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE; // dynamic UBO path; null = set already bound for the command buffer
+    uint32_t uniformOffset = 0;                     // dynamic offset of the draw's slice in the uniform ring
+    uint32_t firstInstance = 0;                     // bindless path: index of the object's MVP in the transform buffer
+    const Mat4* pushMvp = nullptr;                  // push-constant path: pushed right before the draw
+    VkBuffer indirectBuffer = VK_NULL_HANDLE;       // GPU-driven (GpuCuller): one draw command from the GPU...
+    VkBuffer indirectInstances = VK_NULL_HANDLE;    // ... over the compacted instances, bound as vertex binding 1
+    VkBuffer indirectCount = VK_NULL_HANDLE;        // culled plain objects: up to maxDrawCount commands from
+    VkDeviceSize indirectOffset = 0;                // indirectOffset, as many as the count at countOffset says
+    VkDeviceSize countOffset = 0;                   // (vkCmdDrawIndexedIndirectCount)
+    uint32_t maxDrawCount = 0;
+    bool bindVertexBuffers = true;                  // false: the draw list already has this mesh bound
+    bool bindIndexBuffer = true;
+};
+
+// The buffers a draw binds, so the draw list can tell when they are already bound
+struct MeshBuffers {
+    VkBuffer vertex[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE }; // bindings 0 and 1 (per-instance); null = unused
+    VkBuffer index = VK_NULL_HANDLE;                          // always VK_INDEX_TYPE_UINT16
+};
+
+// One instance of an InstancedMeshObject, as the vertex shader reads it (binding 1)
+struct InstanceData {
+    float model[3][4]; // rows 0-2 of the model matrix; row 3 is always 0, 0, 0, 1
+    float color[4];    // multiplies the mesh's vertex colors; alpha unused
+};
+
 // Abstract base class for all renderable objects
 class RenderObject {
 public:
-    virtual ~RenderObject() {
-        if (mvpBuffer) {
-            mvpBuffer->destroy();
-            delete mvpBuffer;
-            mvpBuffer = nullptr;
-        }
-    }
-    virtual void createBuffers(VulkanDevice& device, VkPhysicalDevice physicalDevice) = 0;
-    virtual void recordDraw(VkCommandBuffer cmd, VkPipelineLayout layout, VkDescriptorSet descriptorSet) = 0;
+    virtual ~RenderObject() = default;
+    // Geometry lives in device-local buffers, taken from the deletion queue's free pool and
+    // filled through the upload service's staging ring.
+    // Returns the upload timeline value the first draw has to wait for.
+    virtual uint64_t createBuffers(UploadService& uploads, DeletionQueue& buffers) = 0;
+    // Removing an object while frames are in flight: hands the buffers to the deletion queue
+    // (they're recycled once the GPU is done) instead of destroying them in the destructor
+    virtual void releaseBuffers(DeletionQueue& buffers) = 0;
+    virtual void recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) = 0;
+    virtual MeshBuffers getMeshBuffers() const = 0;
+    // Called on the frame's command buffer before the render pass, once the frame that last
+    // used frameSlot has retired: record copies that bring GPU-side data up to date
+    virtual void recordUpdates(VkCommandBuffer cmd, uint32_t frameSlot, const UploadService& uploads, DeletionQueue& buffers) {}
     // Optionally override to specify pipeline topology
     virtual VulkanPipeline::Topology getTopology() const { return VulkanPipeline::Topology::Triangles; }
+    virtual VulkanPipeline::VertexInput getVertexInput() const { return VulkanPipeline::VertexInput::PerVertex; }
+    // What GPU culling needs: the mesh's index count and mesh-space bounding sphere (center, radius)
+    virtual uint32_t getIndexCount() const = 0;
+    void getBoundingSphere(float sphere[4]) const { std::memcpy(sphere, bounds, sizeof(bounds)); }
 
     // Transform interface
     void setPosition(float x, float y, float z) { position[0]=x; position[1]=y; position[2]=z; }
@@ -36,26 +76,52 @@ public:
     const float* getScale() const { return scale; }
     // Model matrix from transform
     virtual Mat4 getModelMatrix() const;
-    // Per-object MVP buffer and descriptor set
-    VulkanBuffer* mvpBuffer = nullptr;
-    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    // Fixed-timestep support: snapshot the transform before a simulation step, and render
+    // the blend between that snapshot and the current transform (alpha in [0, 1])
+    void storePreviousTransform();
+    Mat4 getInterpolatedModelMatrix(float alpha) const;
 protected:
+    // Binds the descriptor set / pushes the MVP if the path needs it per draw, then draws
+    static void drawIndexed(VkCommandBuffer cmd, const DrawBinding& binding, uint32_t indexCount, uint32_t instanceCount = 1);
+    // Binds whichever of the mesh's buffers binding says aren't bound yet
+    static void bindMesh(VkCommandBuffer cmd, const DrawBinding& binding, const MeshBuffers& mesh);
+    // Sphere around the AABB center: not minimal, but one pass and good enough to cull with
+    static void computeBounds(const std::vector<Vertex>& vertices, float bounds[4]);
+    float bounds[4] = {0, 0, 0, 0}; // set by createBuffers() (or the constructor)
     float position[3] = {0,0,0};
     float rotation[3] = {0,0,0}; // pitch, yaw, roll (radians)
     float scale[3] = {1,1,1};
+    float prevPosition[3] = {0,0,0};
+    float prevRotation[3] = {0,0,0};
+    float prevScale[3] = {1,1,1};
 };
 
 // Pyramid renderable object
+// Every pyramid draws the same mesh, so they all share one pair of buffers: the first
+// createBuffers() uploads it, the last releaseBuffers() hands it to the deletion queue. Draws
+// that share buffers can go out in one vkCmdDrawIndexedIndirectCount (GpuCuller), and the
+// draw list doesn't rebind between pyramids.
 class PyramidObject : public RenderObject {
 public:
     PyramidObject();
     ~PyramidObject() override;
-    void createBuffers(VulkanDevice& device, VkPhysicalDevice physicalDevice) override;
-    void recordDraw(VkCommandBuffer cmd, VkPipelineLayout layout, VkDescriptorSet descriptorSet) override;
+    uint64_t createBuffers(UploadService& uploads, DeletionQueue& buffers) override;
+    void releaseBuffers(DeletionQueue& buffers) override;
+    void recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) override;
+    MeshBuffers getMeshBuffers() const override;
+    uint32_t getIndexCount() const override { return mesh ? mesh->indexCount : 0; }
+    // The pyramid mesh, also used by InstancedMeshObject
+    static void buildMesh(std::vector<Vertex>& vertices, std::vector<uint16_t>& indices);
 private:
-    std::unique_ptr<VulkanBuffer> vertexBuffer = nullptr;
-    std::unique_ptr<VulkanBuffer> indexBuffer = nullptr;
-    uint32_t indexCount = 0;
+    struct SharedMesh {
+        std::unique_ptr<VulkanBuffer> vertexBuffer;
+        std::unique_ptr<VulkanBuffer> indexBuffer;
+        uint32_t indexCount = 0;
+        float bounds[4] = {0, 0, 0, 0};
+        uint64_t upload = 0; // upload timeline value the first draw has to wait for
+    };
+    static std::weak_ptr<SharedMesh> sharedMesh;
+    std::shared_ptr<SharedMesh> mesh;
 };
 
 // Grid renderable object
@@ -63,8 +129,11 @@ class GridObject : public RenderObject {
 public:
     GridObject(int gridSize = 20, float gridSpacing = 0.5f);
     ~GridObject() override;
-    void createBuffers(VulkanDevice& device, VkPhysicalDevice physicalDevice) override;
-    void recordDraw(VkCommandBuffer cmd, VkPipelineLayout layout, VkDescriptorSet descriptorSet) override;
+    uint64_t createBuffers(UploadService& uploads, DeletionQueue& buffers) override;
+    void releaseBuffers(DeletionQueue& buffers) override;
+    void recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) override;
+    MeshBuffers getMeshBuffers() const override;
+    uint32_t getIndexCount() const override { return indexCount; }
     VulkanPipeline::Topology getTopology() const override { return VulkanPipeline::Topology::Lines; }
 private:
     int gridSize;
@@ -73,3 +142,63 @@ private:
     std::unique_ptr<VulkanBuffer> indexBuffer;
     uint32_t indexCount = 0;
 };
+
+
+// Instanced renderable: one mesh, any number of instances, a single draw call
+// The CPU copy of the instances is the source of truth; recordUpdates() brings the
+// device-local instance buffer (vertex binding 1) up to date at the start of each frame by
+// copying only the instances touched since the last frame, coalesced into ranges and staged
+// through a host-visible buffer per frame slot. A full buffer doubles, with a GPU-side copy
+// of the old contents. Removing swaps the last instance into the hole so the buffer stays
+// packed and one vkCmdDrawIndexed covers every instance; handles stay valid regardless.
+// The object's own transform applies on top of every instance (pushed with the MVP).
+class InstancedMeshObject : public RenderObject {
+public:
+    // frameCount: frames in flight, one staging buffer each
+    InstancedMeshObject(std::vector<Vertex> vertices, std::vector<uint16_t> indices, uint32_t frameCount);
+    ~InstancedMeshObject() override;
+    uint64_t createBuffers(UploadService& uploads, DeletionQueue& buffers) override;
+    void releaseBuffers(DeletionQueue& buffers) override;
+    void recordUpdates(VkCommandBuffer cmd, uint32_t frameSlot, const UploadService& uploads, DeletionQueue& buffers) override;
+    void recordDraw(VkCommandBuffer cmd, const DrawBinding& binding) override;
+    MeshBuffers getMeshBuffers() const override;
+    VulkanPipeline::VertexInput getVertexInput() const override { return VulkanPipeline::VertexInput::Instanced; }
+
+    static InstanceData makeInstance(const float position[3], float yaw, float scale, const float color[3]);
+    uint32_t addInstance(const InstanceData& instance); // returns a handle
+    void removeInstance(uint32_t handle);
+    void updateInstance(uint32_t handle, const InstanceData& instance);
+    const InstanceData& getInstance(uint32_t handle) const { return instances[slotOfHandle[handle]]; }
+    uint32_t getInstanceCount() const { return (uint32_t)instances.size(); }
+    uint32_t getCapacity() const { return capacity; }
+    // For GpuCuller: the instances recordUpdates() left on the GPU (bounds: getBoundingSphere())
+    VkBuffer getInstanceBuffer() const { return instanceBuffer ? instanceBuffer->getBuffer() : VK_NULL_HANDLE; }
+    uint32_t getDrawCount() const { return gpuCount; }
+    uint32_t getIndexCount() const override { return (uint32_t)indices.size(); }
+    // What the last recordUpdates() copied
+    VkDeviceSize getFrameBytes() const { return frameBytes; }
+    uint32_t getFrameRanges() const { return frameRanges; }
+private:
+    static constexpr uint32_t MIN_CAPACITY = 1024;
+    std::vector<Vertex> vertices;
+    std::vector<uint16_t> indices;
+    std::vector<InstanceData> instances;  // packed, in draw order
+    std::vector<uint32_t> handleOfSlot;
+    std::vector<uint32_t> slotOfHandle;   // UINT32_MAX for free handles
+    std::vector<uint32_t> freeHandles;
+    std::vector<uint32_t> dirtySlots;     // changed since the last recordUpdates()
+    std::vector<uint8_t> dirtyFlags;      // per slot, so a slot is only queued once
+    std::unique_ptr<VulkanBuffer> vertexBuffer;
+    std::unique_ptr<VulkanBuffer> indexBuffer;
+    std::unique_ptr<VulkanBuffer> instanceBuffer;
+    std::vector<std::unique_ptr<VulkanBuffer>> staging; // per frame slot, persistently mapped
+    std::vector<VkBufferCopy> regions;
+    uint32_t capacity = 0;     // instances the instance buffer has room for
+    uint32_t gpuCount = 0;     // instances the instance buffer holds, i.e. what gets drawn
+    uint64_t initialUpload = 0; // createBuffers() fills the instance buffer on the transfer queue
+    VkDeviceSize frameBytes = 0;
+    uint32_t frameRanges = 0;
+
+    void markDirty(uint32_t slot);
+    void grow(VkCommandBuffer cmd, uint32_t count, DeletionQueue& buffers);
+};
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "RenderTargetAllocator.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "CoreRendering.h"
+
+RenderTargetAllocator::RenderTargetAllocator(VulkanDevice& device)
+    : device(device) {
+    lazyAvailable = device.getAllocator().hasMemoryType(~0u, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+}
+
+RenderTargetAllocator::~RenderTargetAllocator() {
+    release();
+}
+
+uint32_t RenderTargetAllocator::add(const RenderTargetDesc& desc) {
+    Target target;
+    target.desc = desc;
+    targets.push_back(target);
+    return static_cast<uint32_t>(targets.size() - 1);
+}
+
+void RenderTargetAllocator::release() {
+    VkDevice dev = device.getDevice();
+    for (Target& target : targets) {
+        if (target.view) vkDestroyImageView(dev, target.view, nullptr);
+        if (target.image) vkDestroyImage(dev, target.image, nullptr);
+        target.view = VK_NULL_HANDLE;
+        target.image = VK_NULL_HANDLE;
+    }
+    for (Group& group : groups) device.getAllocator().free(group.allocation);
+    groups.clear();
+}
+
+std::function<void()> RenderTargetAllocator::detach() {
+    std::vector<VkImage> images;
+    std::vector<VkImageView> views;
+    std::vector<MemoryAllocation> allocations;
+    for (Target& target : targets) {
+        if (target.view) views.push_back(target.view);
+        if (target.image) images.push_back(target.image);
+        target.view = VK_NULL_HANDLE;
+        target.image = VK_NULL_HANDLE;
+    }
+    for (Group& group : groups) allocations.push_back(group.allocation);
+    groups.clear();
+    VulkanDevice* owner = &device;
+    return [owner, images, views, allocations]() mutable {
+        for (VkImageView view : views) vkDestroyImageView(owner->getDevice(), view, nullptr);
+        for (VkImage image : images) vkDestroyImage(owner->getDevice(), image, nullptr);
+        for (MemoryAllocation& allocation : allocations) owner->getAllocator().free(allocation);
+    };
+}
+
+void RenderTargetAllocator::place(uint32_t index) {
+    Target& target = targets[index];
+    const VkMemoryRequirements& reqs = target.requirements;
+    MemoryAllocator& allocator = device.getAllocator();
+    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (target.desc.transient && allocator.hasMemoryType(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+        properties = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    // Join the first group with the same kind of memory that still has a type every member accepts
+    uint32_t g = 0;
+    for (; g < groups.size(); ++g) {
+        if (groups[g].properties == properties && allocator.hasMemoryType(groups[g].typeBits & reqs.memoryTypeBits, properties))
+            break;
+    }
+    if (g == groups.size()) {
+        groups.emplace_back();
+        groups[g].properties = properties;
+    }
+    Group& group = groups[g];
+    // Lowest offset that doesn't collide with a member whose lifetime overlaps ours. Only
+    // 0 and the ends of such members can be the lowest free offset.
+    auto overlapsLifetime = [&](const Target& other) {
+        return other.desc.firstPass <= target.desc.lastPass && target.desc.firstPass <= other.desc.lastPass;
+    };
+    VkDeviceSize best = UINT64_MAX;
+    auto tryOffset = [&](VkDeviceSize candidate) {
+        candidate = AlignUp(candidate, reqs.alignment);
+        if (candidate >= best) return;
+        for (uint32_t i = 0; i < targets.size(); ++i) {
+            const Target& other = targets[i];
+            if (i == index || !other.image || other.group != g || other.requirements.size == 0) continue;
+            if (!overlapsLifetime(other)) continue;
+            if (candidate < other.offset + other.requirements.size && other.offset < candidate + reqs.size) return;
+        }
+        best = candidate;
+    };
+    tryOffset(0);
+    for (uint32_t i = 0; i < targets.size(); ++i) {
+        const Target& other = targets[i];
+        if (i != index && other.image && other.group == g && other.requirements.size && overlapsLifetime(other))
+            tryOffset(other.offset + other.requirements.size);
+    }
+    target.group = g;
+    target.offset = best;
+    group.typeBits &= reqs.memoryTypeBits;
+    group.size = std::max(group.size, best + reqs.size);
+    group.alignment = std::max(group.alignment, reqs.alignment);
+}
+
+void RenderTargetAllocator::build(VkExtent2D extent) {
+    release();
+    VkDevice dev = device.getDevice();
+    for (Target& target : targets) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { extent.width, extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = target.desc.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = target.desc.usage | (target.desc.transient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateImage(dev, &imageInfo, nullptr, &target.image) != VK_SUCCESS)
+            throw std::runtime_error(std::string("Failed to create render target ") + target.desc.name);
+        vkGetImageMemoryRequirements(dev, target.image, &target.requirements);
+        target.group = UINT32_MAX; // not placed yet
+    }
+    // Biggest first: smaller targets then fill the gaps next to them
+    std::vector<uint32_t> order(targets.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return targets[a].requirements.size > targets[b].requirements.size;
+    });
+    for (uint32_t index : order) place(index);
+
+    footprint = RenderTargetFootprint{};
+    footprint.extent = extent;
+    footprint.targetCount = static_cast<uint32_t>(targets.size());
+    for (Group& group : groups) {
+        VkMemoryRequirements reqs{ group.size, group.alignment, group.typeBits };
+        // Optimal-tiling images only, so the group can sit in the image pools
+        group.allocation = device.getAllocator().allocate(reqs, group.properties, AllocationKind::Optimal, MemoryCategory::RenderTargets);
+        footprint.committedBytes += group.size;
+        if (group.properties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) footprint.lazyBytes += group.size;
+    }
+    for (Target& target : targets) {
+        const MemoryAllocation& allocation = groups[target.group].allocation;
+        vkBindImageMemory(dev, target.image, allocation.memory, allocation.offset + target.offset);
+        footprint.requestedBytes += target.requirements.size;
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = target.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = target.desc.format;
+        viewInfo.subresourceRange = { target.desc.aspect, 0, 1, 0, 1 };
+        if (vkCreateImageView(dev, &viewInfo, nullptr, &target.view) != VK_SUCCESS)
+            throw std::runtime_error(std::string("Failed to create render target view ") + target.desc.name);
+    }
+    // Resizing back and forth between the same sizes shouldn't grow the history
+    auto same = std::find_if(history.begin(), history.end(), [&](const RenderTargetFootprint& f) {
+        return f.extent.width == extent.width && f.extent.height == extent.height;
+    });
+    if (same != history.end()) history.erase(same);
+    history.push_back(footprint);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "VulkanDevice.h"
+#include "MemoryAllocator.h"
+
+// --- RenderTargetAllocator: size-dependent attachments ---
+// Targets are declared once with add() and (re)created for a resolution by build().
+// Transient targets (never loaded or stored, like the depth buffer) get
+// TRANSIENT_ATTACHMENT usage and LAZILY_ALLOCATED memory when the device offers it, so a
+// tiler can keep them in tile memory and never back them at all. Every target names the
+// passes of a frame that use it; targets whose pass ranges don't overlap share memory
+// (same offset in one allocation). An aliased target's contents don't survive, so it has
+// to start each of its passes from UNDEFINED with a CLEAR or DONT_CARE load.
+struct RenderTargetDesc {
+    const char* name = "";
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageUsageFlags usage = 0;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    bool transient = false;
+    uint32_t firstPass = 0, lastPass = 0; // inclusive
+};
+
+struct RenderTargetFootprint {
+    VkExtent2D extent = {0, 0};
+    uint32_t targetCount = 0;
+    VkDeviceSize requestedBytes = 0;  // sum of the images' memory requirements
+    VkDeviceSize committedBytes = 0;  // actually allocated, after aliasing
+    VkDeviceSize lazyBytes = 0;       // part of committedBytes that is lazily allocated
+};
+
+class RenderTargetAllocator {
+public:
+    explicit RenderTargetAllocator(VulkanDevice& device);
+    ~RenderTargetAllocator(); // release()
+
+    // Returns the target's handle; it gets an image at the next build()
+    uint32_t add(const RenderTargetDesc& desc);
+    // Destroys the previous images and creates every target at extent; the GPU must be done with the old ones
+    void build(VkExtent2D extent);
+    void release();
+    // Hands the current images and their memory to the returned closure, which destroys them;
+    // the next build() then doesn't have to wait for the GPU (run the closure once it is done)
+    std::function<void()> detach();
+    VkImage getImage(uint32_t target) const { return targets[target].image; }
+    VkImageView getView(uint32_t target) const { return targets[target].view; }
+    bool hasLazyMemory() const { return lazyAvailable; }
+    const RenderTargetFootprint& getFootprint() const { return footprint; }
+    // One entry per resolution built so far, most recent last
+    const std::vector<RenderTargetFootprint>& getFootprintHistory() const { return history; }
+
+    RenderTargetAllocator(const RenderTargetAllocator&) = delete;
+    RenderTargetAllocator& operator=(const RenderTargetAllocator&) = delete;
+private:
+    struct Target {
+        RenderTargetDesc desc;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkMemoryRequirements requirements{};
+        uint32_t group = 0;      // index into groups
+        VkDeviceSize offset = 0; // inside the group's allocation
+    };
+    struct Group {
+        VkMemoryPropertyFlags properties = 0;
+        uint32_t typeBits = ~0u;
+        VkDeviceSize size = 0;
+        VkDeviceSize alignment = 1;
+        MemoryAllocation allocation;
+    };
+    VulkanDevice& device;
+    bool lazyAvailable = false;
+    std::vector<Target> targets;
+    std::vector<Group> groups;
+    RenderTargetFootprint footprint;
+    std::vector<RenderTargetFootprint> history;
+
+    void place(uint32_t index);
+};
@@ -0,0 +1,97 @@
+#include "TransformBuffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+TransformBuffer::TransformBuffer(VulkanDevice& device, uint32_t frameCount, uint32_t capacity)
+    : device(device), buffers(frameCount, nullptr), capacities(frameCount, 0) {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = frameCount;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+    // Only the element a command buffer pushes is ever read, so the others may be rewritten
+    // while it is pending
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.bindingCount = 1;
+    flagsInfo.pBindingFlags = &bindingFlags;
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create transform descriptor set layout");
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = frameCount;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+    if (vkCreateDescriptorPool(device.getDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create transform descriptor pool");
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &setLayout;
+    if (vkAllocateDescriptorSets(device.getDevice(), &allocInfo, &set) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate transform descriptor set");
+    for (uint32_t slot = 0; slot < frameCount; ++slot) createSlot(slot, capacity);
+}
+
+TransformBuffer::~TransformBuffer() {
+    for (VulkanBuffer* buffer : buffers) {
+        if (!buffer) continue;
+        buffer->destroy();
+        delete buffer;
+    }
+    // The set goes with its pool
+    if (pool) vkDestroyDescriptorPool(device.getDevice(), pool, nullptr);
+    if (setLayout) vkDestroyDescriptorSetLayout(device.getDevice(), setLayout, nullptr);
+}
+
+void TransformBuffer::createSlot(uint32_t slot, uint32_t capacity) {
+    if (buffers[slot]) {
+        buffers[slot]->destroy();
+        delete buffers[slot];
+    }
+    capacities[slot] = std::max<uint32_t>(capacity, 1);
+    buffers[slot] = new VulkanBuffer(device, device.getPhysicalDevice(), (VkDeviceSize)capacities[slot] * sizeof(Mat4),
+                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, // coherent not required: finish() flushes
+                                     MemoryCategory::Uniforms);
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffers[slot]->getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range = VK_WHOLE_SIZE;
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.dstArrayElement = slot;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device.getDevice(), 1, &write, 0, nullptr);
+}
+
+Mat4* TransformBuffer::map(uint32_t slot, uint32_t count) {
+    // Objects were added since the slot was sized: double, so growth stays rare
+    if (count > capacities[slot]) createSlot(slot, std::max(count, capacities[slot] * 2));
+    return static_cast<Mat4*>(buffers[slot]->getMappedData());
+}
+
+void TransformBuffer::finish(uint32_t slot, uint32_t count) {
+    if (count) buffers[slot]->markWritten(0, (VkDeviceSize)count * sizeof(Mat4));
+}
+
+void TransformBuffer::bind(VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t slot) const {
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &slot);
+}
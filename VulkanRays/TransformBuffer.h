@@ -0,0 +1,44 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "MathUtils.h"
+
+// --- TransformBuffer: bindless per-object transforms ---
+// The scene's global descriptor set, allocated once. Binding 0 is a runtime-sized array of
+// storage buffers, one per frame in flight, each holding that frame's MVPs in renderObjects
+// order. bind() binds the set once per command buffer and pushes the frame's slot; every draw
+// then passes firstInstance = object index (DrawPath::Bindless), so there is no per-draw
+// descriptor work and no per-object descriptor or pool limit.
+// Needs VulkanDevice::hasDescriptorIndexing(): the binding is PARTIALLY_BOUND and
+// UPDATE_UNUSED_WHILE_PENDING, so a slot that outgrows its buffer can rewrite its own array
+// element while other frames' command buffers, which never index it, are still pending.
+// Material data would go in binding 1 of the same set.
+class TransformBuffer {
+public:
+    TransformBuffer(VulkanDevice& device, uint32_t frameCount, uint32_t capacity);
+    ~TransformBuffer();
+
+    // count MVPs to write in place; grows the slot's buffer first if needed, so only call it
+    // once the frame that last used the slot has retired
+    Mat4* map(uint32_t slot, uint32_t count);
+    void finish(uint32_t slot, uint32_t count); // after writing: marks the MVPs for flushing
+    // Once per command buffer (primary or secondary) before the first draw
+    void bind(VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t slot) const;
+    VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+    VkDescriptorSet getSet() const { return set; } // also read by GpuCuller's object culling (compute)
+    uint32_t getCapacity(uint32_t slot) const { return capacities[slot]; }
+
+    TransformBuffer(const TransformBuffer&) = delete;
+    TransformBuffer& operator=(const TransformBuffer&) = delete;
+private:
+    VulkanDevice& device;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    std::vector<VulkanBuffer*> buffers;   // per frame slot, persistently mapped
+    std::vector<uint32_t> capacities;     // in MVPs
+    void createSlot(uint32_t slot, uint32_t capacity);
+};
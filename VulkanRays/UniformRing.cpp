@@ -0,0 +1,31 @@
+#include "UniformRing.h"
+#include <algorithm>
+#include <stdexcept>
+#include "CoreRendering.h"
+
+UniformRing::UniformRing(VulkanDevice& device, VkDeviceSize capacity)
+    : alignment(std::max<VkDeviceSize>(device.getProperties().limits.minUniformBufferOffsetAlignment, 16)) {
+    this->capacity = AlignUp(std::max<VkDeviceSize>(capacity, alignment), alignment);
+    buffer = new VulkanBuffer(device, device.getPhysicalDevice(), this->capacity, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, // coherent not required: finish() flushes
+                              MemoryCategory::Uniforms);
+    mapped = static_cast<unsigned char*>(buffer->getMappedData());
+}
+
+UniformRing::~UniformRing() {
+    buffer->destroy();
+    delete buffer;
+}
+
+UniformSlice UniformRing::allocate(VkDeviceSize size) {
+    VkDeviceSize aligned = AlignUp(size, alignment);
+    VkDeviceSize offset = head.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + aligned > capacity)
+        throw std::runtime_error("Failed to allocate uniform data: per-frame ring is full");
+    return { static_cast<uint32_t>(offset), mapped + offset };
+}
+
+void UniformRing::finish() {
+    VkDeviceSize used = std::min(getUsed(), capacity);
+    if (used) buffer->markWritten(0, used);
+}
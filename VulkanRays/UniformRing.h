@@ -0,0 +1,41 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+
+// --- UniformRing: per-frame linear allocator for uniform data ---
+// One persistently mapped buffer per frame in flight. reset() at the start of a frame,
+// allocate() bump-allocates minUniformBufferOffsetAlignment-aligned slices (lock-free, so
+// recording threads can share it), finish() queues the used range for flushing. Shaders
+// see it through a single VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor whose dynamic
+// offset picks the slice, so one descriptor set serves every draw of the frame.
+struct UniformSlice {
+    uint32_t offset = 0;   // dynamic offset for vkCmdBindDescriptorSets
+    void* data = nullptr;  // mapped pointer to write through
+};
+
+class UniformRing {
+public:
+    UniformRing(VulkanDevice& device, VkDeviceSize capacity);
+    ~UniformRing();
+
+    // Throws std::runtime_error when the frame's data doesn't fit
+    UniformSlice allocate(VkDeviceSize size);
+    void reset() { head.store(0, std::memory_order_relaxed); }
+    void finish(); // after recording: marks [0, used) written
+    VkBuffer getBuffer() const { return buffer->getBuffer(); }
+    VkDeviceSize getCapacity() const { return capacity; }
+    VkDeviceSize getUsed() const { return head.load(std::memory_order_relaxed); }
+    VkDeviceSize getAlignment() const { return alignment; }
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+private:
+    VulkanBuffer* buffer = nullptr;
+    unsigned char* mapped = nullptr;
+    VkDeviceSize capacity;
+    VkDeviceSize alignment;
+    std::atomic<VkDeviceSize> head{0};
+};
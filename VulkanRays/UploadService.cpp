@@ -0,0 +1,257 @@
+#include "UploadService.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "CpuTrace.h"
+
+namespace {
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+}
+
+UploadService::UploadService(VulkanDevice& device, VkDeviceSize ringSize, uint32_t maxBatches)
+    : device(device), queue(device.getTransferQueue()),
+      onGraphicsQueue(device.getTransferQueueFamily() == device.getGraphicsQueueFamily()),
+      ringSize(ringSize), batches(maxBatches) {
+    ring = new VulkanBuffer(device, device.getPhysicalDevice(), ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryCategory::Staging);
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device.getTransferQueueFamily();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(device.getDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload command pool");
+    std::vector<VkCommandBuffer> buffers(maxBatches);
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = maxBatches;
+    if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, buffers.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate upload command buffers");
+    for (uint32_t i = 0; i < maxBatches; ++i) batches[i].cmd = buffers[i];
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    VkSemaphoreCreateInfo semInfo{};
+    semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semInfo.pNext = &typeInfo;
+    if (vkCreateSemaphore(device.getDevice(), &semInfo, nullptr, &timeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload timeline semaphore");
+    pending.reserve(1024);
+    regions.reserve(1024);
+}
+
+UploadService::~UploadService() {
+    // Anything still queued targets buffers that may already be gone: drop it
+    pending.clear();
+    pendingImages.clear();
+    while (batchesInFlight > 0) retire(true);
+    if (timeline) vkDestroySemaphore(device.getDevice(), timeline, nullptr);
+    if (commandPool) vkDestroyCommandPool(device.getDevice(), commandPool, nullptr);
+    delete ring;
+}
+
+VkDeviceSize UploadService::reserve(VkDeviceSize size) {
+    // Contiguous space only: a request that doesn't fit before the end skips to offset 0 and
+    // the skipped tail counts as used until the batch that owns it retires
+    if (ringUsed == 0) ringHead = 0;
+    for (;;) {
+        VkDeviceSize start = (ringHead + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+        VkDeviceSize padding = start - ringHead;
+        if (start + size > ringSize) {
+            padding = ringSize - ringHead;
+            start = 0;
+        }
+        if (ringUsed + padding + size <= ringSize) {
+            ringUsed += padding + size;
+            pendingRingBytes += padding + size;
+            ringHead = start + size;
+            return start;
+        }
+        // Full: hand what is queued to the GPU and wait for the oldest batch to give space back
+        if (hasPending()) flush();
+        if (batchesInFlight == 0) throw std::runtime_error("Failed to reserve staging memory: upload larger than the ring");
+        retire(true);
+    }
+}
+
+uint64_t UploadService::upload(VulkanBuffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+    if (size == 0) return 0;
+    const char* src = static_cast<const char*>(data);
+    // Big uploads go through in ring-sized pieces
+    VkDeviceSize chunkLimit = ringSize / 2;
+    for (VkDeviceSize done = 0; done < size;) {
+        VkDeviceSize chunk = std::min(size - done, chunkLimit);
+        VkDeviceSize offset = reserve(chunk);
+        if (!hasPending()) pendingFirstUpload = std::chrono::steady_clock::now();
+        ring->write(offset, src + done, chunk);
+        pending.push_back({ dst.getBuffer(), { offset, dstOffset + done, chunk } });
+        current.frameBytes += chunk;
+        ++current.frameCopies;
+        stats.totalBytes += chunk;
+        done += chunk;
+    }
+    return submittedValue + 1; // the batch the last chunk is queued in
+}
+
+uint64_t UploadService::uploadImage(VkImage image, VkExtent3D extent, VkImageAspectFlags aspect, VkImageLayout finalLayout,
+                                    const void* data, VkDeviceSize size) {
+    // bufferOffset has to be a multiple of the texel size; the ring's 16-byte alignment covers
+    // every uncompressed and block-compressed format
+    if (size > ringSize) throw std::runtime_error("Failed to upload image: larger than the staging ring");
+    VkDeviceSize offset = reserve(size);
+    if (!hasPending()) pendingFirstUpload = std::chrono::steady_clock::now();
+    ring->write(offset, data, size);
+    VkBufferImageCopy region{};
+    region.bufferOffset = offset;
+    region.imageSubresource.aspectMask = aspect;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = extent;
+    pendingImages.push_back({ image, region, finalLayout });
+    current.frameBytes += size;
+    ++current.frameCopies;
+    stats.totalBytes += size;
+    return submittedValue + 1;
+}
+
+uint64_t UploadService::flush() {
+    if (!hasPending()) return 0;
+    TRACE_ZONE("UploadService::flush");
+    if (batchesInFlight == batches.size()) retire(true);
+    Batch& batch = batches[(oldestBatch + batchesInFlight) % batches.size()];
+    vkResetCommandBuffer(batch.cmd, 0);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch.cmd, &beginInfo);
+    // On the graphics queue destinations may still be read by frames in flight: order the
+    // copies after those reads. Images start from UNDEFINED either way.
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    imageBarriers.clear();
+    for (const PendingImageCopy& copy : pendingImages) {
+        VkImageMemoryBarrier imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = copy.image;
+        imageBarrier.subresourceRange = { copy.region.imageSubresource.aspectMask, 0, 1, 0, 1 };
+        imageBarriers.push_back(imageBarrier);
+    }
+    VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    vkCmdPipelineBarrier(batch.cmd, onGraphicsQueue ? readStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, onGraphicsQueue ? 1 : 0, &barrier,
+                         0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+    // One vkCmdCopyBuffer per destination with all of its regions
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingCopy& a, const PendingCopy& b) { return a.dst < b.dst; });
+    for (size_t i = 0; i < pending.size();) {
+        size_t end = i;
+        regions.clear();
+        while (end < pending.size() && pending[end].dst == pending[i].dst) regions.push_back(pending[end++].region);
+        vkCmdCopyBuffer(batch.cmd, ring->getBuffer(), pending[i].dst, (uint32_t)regions.size(), regions.data());
+        i = end;
+    }
+    for (const PendingImageCopy& copy : pendingImages)
+        vkCmdCopyBufferToImage(batch.cmd, ring->getBuffer(), copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.region);
+    // ...and make them visible to everything submitted later on this queue. On the transfer
+    // queue the consumer's semaphore wait does that; only the layout change is recorded here.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    for (size_t i = 0; i < imageBarriers.size(); ++i) {
+        VkImageMemoryBarrier& imageBarrier = imageBarriers[i];
+        imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.dstAccessMask = onGraphicsQueue ? VK_ACCESS_SHADER_READ_BIT : 0;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageBarrier.newLayout = pendingImages[i].finalLayout;
+    }
+    vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         onGraphicsQueue ? readStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0, onGraphicsQueue ? 1 : 0, &barrier, 0, nullptr,
+                         (uint32_t)imageBarriers.size(), imageBarriers.data());
+    vkEndCommandBuffer(batch.cmd);
+    device.getAllocator().flushPending(); // staging writes, if the ring isn't coherent
+
+    batch.value = ++submittedValue;
+    batch.ringBytes = pendingRingBytes;
+    batch.firstUpload = pendingFirstUpload;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.value;
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timeline;
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit upload command buffer");
+    ++batchesInFlight;
+    ++current.frameBatches;
+    pending.clear();
+    pendingImages.clear();
+    pendingRingBytes = 0;
+    return batch.value;
+}
+
+void UploadService::retire(bool waitForOldest) {
+    if (batchesInFlight == 0) return;
+    if (waitForOldest) {
+        TRACE_ZONE("UploadService::wait");
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timeline;
+        waitInfo.pValues = &batches[oldestBatch].value;
+        if (vkWaitSemaphores(device.getDevice(), &waitInfo, UINT64_MAX) != VK_SUCCESS)
+            throw std::runtime_error("Failed to wait for upload timeline");
+    }
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device.getDevice(), timeline, &completed);
+    auto now = std::chrono::steady_clock::now();
+    while (batchesInFlight > 0 && batches[oldestBatch].value <= completed) {
+        Batch& batch = batches[oldestBatch];
+        ringUsed -= batch.ringBytes;
+        stats.lastLatencyMs = std::chrono::duration<double, std::milli>(now - batch.firstUpload).count();
+        stats.maxLatencyMs = std::max(stats.maxLatencyMs, stats.lastLatencyMs);
+        batch.value = 0;
+        oldestBatch = (oldestBatch + 1) % (uint32_t)batches.size();
+        --batchesInFlight;
+    }
+}
+
+bool UploadService::isComplete(uint64_t value) const {
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device.getDevice(), timeline, &completed);
+    return completed >= value;
+}
+
+void UploadService::wait(uint64_t value) {
+    if (value > submittedValue) flush();
+    if (isComplete(value)) return;
+    TRACE_ZONE("UploadService::wait");
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timeline;
+    waitInfo.pValues = &value;
+    if (vkWaitSemaphores(device.getDevice(), &waitInfo, UINT64_MAX) != VK_SUCCESS)
+        throw std::runtime_error("Failed to wait for upload timeline");
+}
+
+void UploadService::beginFrame() {
+    retire(false);
+    stats.frameBytes = current.frameBytes;
+    stats.frameCopies = current.frameCopies;
+    stats.frameBatches = current.frameBatches;
+    current = UploadStats{};
+}
+
+void UploadService::waitIdle() {
+    flush();
+    while (batchesInFlight > 0) retire(true);
+}
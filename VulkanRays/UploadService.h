@@ -0,0 +1,97 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+
+// --- UploadService: staging ring -> device-local buffers and images ---
+// upload() copies the data into a persistently mapped staging ring and queues a
+// VkBufferCopy; flush() records every queued copy (grouped per destination) into one
+// command buffer and submits it on the device's transfer queue (the graphics queue if
+// there is no dedicated one). Batches signal a timeline semaphore; ring space is
+// reclaimed once their value has been reached. When the ring is full, upload() flushes and
+// waits for the oldest batch, so arbitrarily large uploads still work (just slower).
+//
+// Every upload returns the timeline value of the batch it lands in. Graphics work that
+// reads the data waits for that value (getTimelineSemaphore) - only the first submission
+// that uses it needs to. On a dedicated transfer queue destinations must not be in use by
+// the GPU (fresh or retired resources) and must be VK_SHARING_MODE_CONCURRENT.
+struct UploadStats {
+    VkDeviceSize frameBytes = 0;   // bytes staged during the previous frame
+    uint32_t frameCopies = 0;
+    uint32_t frameBatches = 0;     // submissions during the previous frame
+    double lastLatencyMs = 0.0;    // first upload() of a batch -> batch seen complete on the CPU
+    double maxLatencyMs = 0.0;
+    VkDeviceSize totalBytes = 0;
+};
+
+class UploadService {
+public:
+    UploadService(VulkanDevice& device, VkDeviceSize ringSize = 16ull << 20, uint32_t maxBatches = 8);
+    ~UploadService(); // waits for submitted batches, drops unsubmitted copies
+
+    // dst needs VK_BUFFER_USAGE_TRANSFER_DST_BIT; data is copied, the caller may free it right away.
+    // Returns the timeline value that signals completion (reached after the next flush()).
+    uint64_t upload(VulkanBuffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+    // Whole-image upload of mip 0 / layer 0, tightly packed; the image goes from UNDEFINED to
+    // finalLayout. Needs VK_IMAGE_USAGE_TRANSFER_DST_BIT.
+    uint64_t uploadImage(VkImage image, VkExtent3D extent, VkImageAspectFlags aspect, VkImageLayout finalLayout,
+                         const void* data, VkDeviceSize size);
+    // Submits everything queued in one batch. Returns its timeline value (0 = nothing queued).
+    // Must be called before any submission that waits on a value returned by upload().
+    uint64_t flush();
+    bool isComplete(uint64_t value) const;
+    // Value of the newest batch, queued or submitted (complete once everything so far is)
+    uint64_t getLatestValue() const { return hasPending() ? submittedValue + 1 : submittedValue; }
+    void wait(uint64_t value);
+    VkSemaphore getTimelineSemaphore() const { return timeline; }
+    bool usesDedicatedQueue() const { return !onGraphicsQueue; }
+    // Once per frame: retires finished batches and rolls the per-frame stats
+    void beginFrame();
+    void waitIdle();
+    const UploadStats& getStats() const { return stats; }
+
+    UploadService(const UploadService&) = delete;
+    UploadService& operator=(const UploadService&) = delete;
+private:
+    struct PendingCopy {
+        VkBuffer dst;
+        VkBufferCopy region;
+    };
+    struct PendingImageCopy {
+        VkImage image;
+        VkBufferImageCopy region;
+        VkImageLayout finalLayout;
+    };
+    struct Batch {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        uint64_t value = 0;          // timeline value, 0 = free
+        VkDeviceSize ringBytes = 0;  // ring space (incl. wrap padding) released on retirement
+        std::chrono::steady_clock::time_point firstUpload;
+    };
+    VulkanDevice& device;
+    VkQueue queue;
+    bool onGraphicsQueue;            // graphics stages may appear in barriers
+    VulkanBuffer* ring = nullptr;
+    VkDeviceSize ringSize;
+    VkDeviceSize ringHead = 0;       // next write position
+    VkDeviceSize ringUsed = 0;       // bytes owned by pending + in-flight batches
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    uint64_t submittedValue = 0;
+    std::vector<Batch> batches;      // in-flight ring, oldest first from oldestBatch
+    uint32_t oldestBatch = 0, batchesInFlight = 0;
+    std::vector<PendingCopy> pending;
+    std::vector<PendingImageCopy> pendingImages;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferCopy> regions;
+    VkDeviceSize pendingRingBytes = 0;
+    std::chrono::steady_clock::time_point pendingFirstUpload;
+    UploadStats stats, current;
+
+    VkDeviceSize reserve(VkDeviceSize size);
+    bool hasPending() const { return !pending.empty() || !pendingImages.empty(); }
+    void retire(bool waitForOldest);
+};
@@ -3,23 +3,82 @@
 #include <stdexcept>
 #include "MathUtils.h"
 #include <vector>
+#include <cstring>
+#include <algorithm>
 #include "imgui.h"
 #include "backends/imgui_impl_sdl2.h"
 #include "backends/imgui_impl_vulkan.h"
 #include "RenderObject.h"
 #include <SDL_vulkan.h>
 #include "CoreRendering.h"
+#include <filesystem>
+#include <thread>
+#include <cstdio>
 
-VulkanApp::VulkanApp() {}
+namespace {
+// The ImGui Vulkan backend is built with IMGUI_IMPL_VULKAN_NO_PROTOTYPES (see CMakeLists.txt)
+// and loads its functions through LoadImGuiVulkanFunction, which wraps vkAllocateMemory /
+// vkFreeMemory so its font texture and vertex/index buffers are counted as MemoryCategory::UI.
+MemoryAllocator* imguiMemory = nullptr;
+VkInstance imguiInstance = VK_NULL_HANDLE;
+
+VKAPI_ATTR VkResult VKAPI_CALL TrackedAllocateMemory(VkDevice device, const VkMemoryAllocateInfo* info,
+                                                     const VkAllocationCallbacks* callbacks, VkDeviceMemory* memory) {
+    VkResult result = vkAllocateMemory(device, info, callbacks, memory);
+    if (result == VK_SUCCESS && imguiMemory) imguiMemory->trackExternal(*memory, info->allocationSize, MemoryCategory::UI);
+    return result;
+}
+
+VKAPI_ATTR void VKAPI_CALL TrackedFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* callbacks) {
+    if (memory && imguiMemory) imguiMemory->untrackExternal(memory);
+    vkFreeMemory(device, memory, callbacks);
+}
+
+PFN_vkVoidFunction LoadImGuiVulkanFunction(const char* name, void*) {
+    if (std::strcmp(name, "vkAllocateMemory") == 0) return reinterpret_cast<PFN_vkVoidFunction>(&TrackedAllocateMemory);
+    if (std::strcmp(name, "vkFreeMemory") == 0) return reinterpret_cast<PFN_vkVoidFunction>(&TrackedFreeMemory);
+    return vkGetInstanceProcAddr(imguiInstance, name);
+}
+
+// Sort id for a mesh: equal buffers give equal ids, which is all the draw list needs
+uint32_t MeshSortId(VkBuffer vertexBuffer) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &vertexBuffer, sizeof(vertexBuffer));
+    return (uint32_t)(bits ^ (bits >> 24) ^ (bits >> 48));
+}
+}
+
+VulkanApp::VulkanApp(const AppOptions& options)
+    : options(options), defragBudgetKiB((int)options.defragBudgetKiB), sortDraws(options.sortDraws), requestedPresentMode(options.presentMode),
+      fpsLimit((int)options.fpsLimit) {}
 VulkanApp::~VulkanApp() {
-    // Destroy all render objects (and their VulkanBuffers) before device destruction
-    renderObjects.clear();
     if (vkDevice && vkDevice->getDevice()) {
         vkDeviceWaitIdle(vkDevice->getDevice());
     }
+    // Destroy all render objects (and their VulkanBuffers) before device destruction
+    renderObjects.clear();
+    if (gpuCuller) delete gpuCuller;
+    if (defragmenter) delete defragmenter;
+    if (deletionQueue) delete deletionQueue;
     cleanupVulkanResources();
+    if (vkDevice) {
+        for (auto& frame : frames) DestroyFrameContext(vkDevice->getDevice(), frame);
+        DestroyOffscreenTarget(vkDevice->getDevice(), offscreenTarget);
+    }
+    if (renderTargets) delete renderTargets;
     if (pipeline) delete pipeline;
     if (gridPipeline) delete gridPipeline;
+    if (bindlessPipeline) delete bindlessPipeline;
+    if (bindlessGridPipeline) delete bindlessGridPipeline;
+    if (pushPipeline) delete pushPipeline;
+    if (pushGridPipeline) delete pushGridPipeline;
+    if (instancedPipeline) delete instancedPipeline;
+    if (transformBuffer) delete transformBuffer;
+    if (frameScheduler) delete frameScheduler;
+    if (uploadService) delete uploadService;
+    if (benchmark) delete benchmark;
+    if (gpuProfiler) delete gpuProfiler;
+    if (workerPool) delete workerPool;
     if (swapchain) delete swapchain;
     if (vkDevice) delete vkDevice;
     if (vkInstance) delete vkInstance;
@@ -27,27 +86,28 @@ VulkanApp::~VulkanApp() {
     SDL_Quit();
 }
 
-void VulkanApp::cleanupVulkanResources() {
-    // Destroy framebuffers
+void VulkanApp::destroySwapchainResources() {
+    // Everything that depends on the swapchain extent/images: framebuffers and depth
     for (auto fb : framebuffers) {
         if (fb) vkDestroyFramebuffer(vkDevice->getDevice(), fb, nullptr);
     }
     framebuffers.clear();
-    // Destroy command buffers
-    if (!commandBuffers.empty() && commandPool) {
-        vkFreeCommandBuffers(vkDevice->getDevice(), commandPool, (uint32_t)commandBuffers.size(), commandBuffers.data());
-    }
-    commandBuffers.clear();
-    // Destroy command pool
-    if (commandPool) {
-        vkDestroyCommandPool(vkDevice->getDevice(), commandPool, nullptr);
-        commandPool = VK_NULL_HANDLE;
-    }
-    // Destroy sync objects
-    DestroySyncObjects(vkDevice->getDevice(), syncObjects);
-    imageAvailableSemaphores.clear();
-    renderFinishedSemaphores.clear();
-    inFlightFences.clear();
+    // Render targets are rebuilt in place by buildRenderTargets()
+}
+
+void VulkanApp::buildRenderTargets() {
+    renderTargets->build(getRenderExtent());
+    depthResources.image = renderTargets->getImage(depthResources.target);
+    depthResources.view = renderTargets->getView(depthResources.target);
+    for (size_t i = 0; i < offscreenTarget.targets.size(); ++i) {
+        offscreenTarget.images[i] = renderTargets->getImage(offscreenTarget.targets[i]);
+        offscreenTarget.imageViews[i] = renderTargets->getView(offscreenTarget.targets[i]);
+    }
+}
+
+void VulkanApp::cleanupVulkanResources() {
+    destroySwapchainResources();
+    // Frame contexts and sync objects (FrameScheduler) survive swapchain recreation; destroyed in ~VulkanApp
     // Destroy descriptor pools
     if (uboDescriptorPool) {
         vkDestroyDescriptorPool(vkDevice->getDevice(), uboDescriptorPool, nullptr);
@@ -57,12 +117,6 @@ void VulkanApp::cleanupVulkanResources() {
         vkDestroyDescriptorPool(vkDevice->getDevice(), samplerDescriptorPool, nullptr);
         samplerDescriptorPool = VK_NULL_HANDLE;
     }
-    if (descriptorPool) {
-        vkDestroyDescriptorPool(vkDevice->getDevice(), descriptorPool, nullptr);
-        descriptorPool = VK_NULL_HANDLE;
-    }
-    // Modularized: destroy depth resources
-    DestroyDepthResources(vkDevice->getDevice(), depthResources);
     // Do NOT destroy descriptor set layout here!
     //if (descriptorSetLayout) {
     //    vkDestroyDescriptorSetLayout(vkDevice->getDevice(), descriptorSetLayout, nullptr);
@@ -75,132 +129,330 @@ void VulkanApp::cleanupVulkanResources() {
     }
 }
 
-// --- VulkanApp private members for rendering ---
-VkRenderPass renderPass = VK_NULL_HANDLE;
-std::vector<VkFramebuffer> framebuffers;
-VkCommandPool commandPool = VK_NULL_HANDLE;
-std::vector<VkCommandBuffer> commandBuffers;
-VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
-VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
-VkFence inFlightFence = VK_NULL_HANDLE;
-
-// Add a constant for max frames in flight (triple buffering)
-constexpr int MAX_FRAMES_IN_FLIGHT = 3;
-
 int VulkanApp::run() {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
-        std::cerr << "SDL Init Error: " << SDL_GetError() << "\n";
-        return 1;
-    }
-    window = SDL_CreateWindow("VulkanRays", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1280,720, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-    if (!window) {
-        std::cerr << "SDL_CreateWindow failed\n";
-        return 1;
+    if (!options.headless) {
+        if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+            std::cerr << "SDL Init Error: " << SDL_GetError() << "\n";
+            return 1;
+        }
+        window = SDL_CreateWindow("VulkanRays", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, (int)options.width, (int)options.height, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+        if (!window) {
+            std::cerr << "SDL_CreateWindow failed\n";
+            return 1;
+        }
     }
-    vkInstance = new VulkanInstance(window, true);
+    // Headless: no window -> no surface, and the device is picked without present support
+    vkInstance = new VulkanInstance(window, options.enableValidation);
     vkDevice = new VulkanDevice(vkInstance->getInstance(), vkInstance->getSurface());
-    swapchain = new VulkanSwapchain(*vkDevice, vkInstance->getSurface(), window);
-    // Create depth resources before render pass/framebuffers
-    depthResources.format = FindSupportedDepthFormat(vkDevice->getPhysicalDevice());
-    CreateDepthResources(
-        vkDevice->getDevice(),
-        vkDevice->getPhysicalDevice(),
-        swapchain->getExtent(),
-        depthResources.format,
-        depthResources,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
-    );
+    renderTargets = new RenderTargetAllocator(*vkDevice);
+    if (options.headless) {
+        CreateOffscreenTarget(*vkDevice, *renderTargets, { options.width, options.height }, VK_FORMAT_R8G8B8A8_SRGB, MAX_FRAMES_IN_FLIGHT, offscreenTarget);
+        pendingReadbacks.assign(MAX_FRAMES_IN_FLIGHT, 0);
+        if (!options.outputDir.empty())
+            std::filesystem::create_directories(options.outputDir);
+    } else {
+        swapchain = new VulkanSwapchain(*vkDevice, vkInstance->getSurface(), window, requestedPresentMode);
+    }
+    // Create depth (and offscreen color) targets before render pass/framebuffers
+    AddDepthTarget(*renderTargets, FindSupportedDepthFormat(vkDevice->getPhysicalDevice()), depthResources);
+    buildRenderTargets();
+    if (!options.benchScenario.empty()) {
+        BenchScenario scenario;
+        FindBenchScenario(options.benchScenario, scenario);
+        benchmark = new Benchmark(scenario, options.warmupFrames, options.frames);
+    }
     createDescriptorSetLayout();
+    createSyncObjects();
+    uploadService = new UploadService(*vkDevice);
+    deletionQueue = new DeletionQueue(*vkDevice, *frameScheduler, *uploadService);
+    defragmenter = new Defragmenter(*vkDevice, *deletionQueue, *uploadService);
     createBuffers();
-    // Inline UBO descriptor pool creation
-    CreateUBODescriptorPool(vkDevice->getDevice(), static_cast<uint32_t>(renderObjects.size()), uboDescriptorPool);
+    createFrameContexts();
+    // Bindless: one global set over the frames' transform buffers, each sized like the uniform ring
+    if (vkDevice->hasDescriptorIndexing())
+        transformBuffer = new TransformBuffer(*vkDevice, MAX_FRAMES_IN_FLIGHT, (uint32_t)std::max<size_t>(renderObjects.size() * 2, 64));
+    drawPath = supportedDrawPath(options.drawPath);
+    // Plain objects are culled out of the transform buffer, so they need that and drawIndirectCount
+    bool objectCulling = transformBuffer && vkDevice->hasIndirectCount();
+    if (vkDevice->hasGpuDrivenDraws() && (instancedPyramids || objectCulling))
+        gpuCuller = new GpuCuller(*vkDevice, MAX_FRAMES_IN_FLIGHT, objectCulling ? transformBuffer->getSetLayout() : VK_NULL_HANDLE);
+    if (options.gpuCulling) {
+        if (!vkDevice->hasGpuDrivenDraws())
+            std::cerr << "Graphics queue has no compute support, GPU culling disabled\n";
+        else if (!gpuCuller)
+            std::cerr << "--gpu-culling needs an instanced scene (--instanced) or drawIndirectCount, ignoring it\n";
+        else
+            gpuCulling = true;
+        if (gpuCulling && !instancedPyramids && drawPath != DrawPath::Bindless)
+            std::cerr << "--gpu-culling only culls plain objects on the bindless draw path (--draw-path bindless)\n";
+    }
+    gpuProfiler = new GpuProfiler(*vkDevice, MAX_FRAMES_IN_FLIGHT);
+    // One dynamic-UBO set per frame in flight, however many objects there are
+    CreateUBODescriptorPool(vkDevice->getDevice(), MAX_FRAMES_IN_FLIGHT, uboDescriptorPool, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
     // Inline sampler descriptor pool creation
     CreateSamplerDescriptorPool(vkDevice->getDevice(), static_cast<uint32_t>(renderObjects.size()), samplerDescriptorPool);
     createDescriptorSet();
+    // A --bench-draw-paths sweep starts at its first entry (see finishBenchmark)
+    if (benchmark && !options.benchDrawPathSweep.empty()) applyBenchmarkSweepRun(0);
     createRenderPass();
     createFramebuffers();
-    createCommandPool();
-    createCommandBuffers();
-    createSyncObjects();
-    // Create pipelines: one for triangles (pyramid), one for lines (grid)
-    pipeline = new VulkanPipeline(vkDevice->getDevice(), swapchain->getExtent(), renderPass, descriptorSetLayout, VulkanPipeline::Topology::Triangles);
-    gridPipeline = new VulkanPipeline(vkDevice->getDevice(), swapchain->getExtent(), renderPass, descriptorSetLayout, VulkanPipeline::Topology::Lines);
+    createPipelines();
+    if (options.headless) {
+        headlessLoop();
+        if (!options.traceFile.empty()) dumpCpuTrace();
+        return 0;
+    }
     initImGui();
     mainLoop();
     shutdownImGui();
+    if (!options.traceFile.empty()) dumpCpuTrace();
     return 0;
 }
 
 void VulkanApp::createBuffers() {
-    // Modular: create all render objects
+    // Modular: create all render objects. The interactive scene is the "default" benchmark
+    // scenario (grid + 3 pyramids side by side); --bench can pick a scaled-up one.
+    BenchScenario scene;
+    if (benchmark) scene = benchmark->getScenario();
+    else FindBenchScenario("default", scene);
     renderObjects.clear();
-    renderObjects.push_back(std::make_unique<GridObject>(20, 0.5f));
-    // Create 3 pyramids side by side
-    auto pyramid1 = std::make_unique<PyramidObject>();
-    pyramid1->setPosition(-1.5f, 0.0f, 0.0f);
-    auto pyramid2 = std::make_unique<PyramidObject>();
-    pyramid2->setPosition(0.0f, 0.0f, 0.0f);
-    auto pyramid3 = std::make_unique<PyramidObject>();
-    pyramid3->setPosition(1.5f, 0.0f, 0.0f);
-    renderObjects.push_back(std::move(pyramid1));
-    renderObjects.push_back(std::move(pyramid2));
-    renderObjects.push_back(std::move(pyramid3));
+    renderObjects.push_back(std::make_unique<GridObject>(scene.gridLines, scene.gridSpacing));
+    if (options.instanced || scene.instanced) {
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        PyramidObject::buildMesh(vertices, indices);
+        auto mesh = std::make_unique<InstancedMeshObject>(std::move(vertices), std::move(indices), MAX_FRAMES_IN_FLIGHT);
+        instancedPyramids = mesh.get();
+        renderObjects.push_back(std::move(mesh));
+        pyramidInstances.reserve((size_t)scene.pyramidRows * scene.pyramidCols);
+    }
+    const float white[3] = { 1.0f, 1.0f, 1.0f };
+    for (int row = 0; row < scene.pyramidRows; ++row) {
+        for (int col = 0; col < scene.pyramidCols; ++col) {
+            float position[3] = { (col - 0.5f * (scene.pyramidCols - 1)) * scene.pyramidSpacing, 0.0f,
+                                  (row - 0.5f * (scene.pyramidRows - 1)) * scene.pyramidSpacing };
+            if (instancedPyramids) {
+                pyramidInstances.push_back(instancedPyramids->addInstance(InstancedMeshObject::makeInstance(position, 0.0f, 1.0f, white)));
+                continue;
+            }
+            auto pyramid = std::make_unique<PyramidObject>();
+            pyramid->setPosition(position[0], position[1], position[2]);
+            renderObjects.push_back(std::move(pyramid));
+        }
+    }
     for (auto& obj : renderObjects) {
-        obj->createBuffers(*vkDevice, vkDevice->getPhysicalDevice());
+        requiredUploadValue = std::max(requiredUploadValue, obj->createBuffers(*uploadService, *deletionQueue));
+        obj->storePreviousTransform();
+    }
+}
+
+void VulkanApp::addPyramid() {
+    // New pyramids fill rows of 8 behind the initial scene
+    size_t index = instancedPyramids ? pyramidInstances.size() : renderObjects.size() - 1; // index 0 is the grid
+    float position[3] = { ((float)(index % 8) - 3.5f) * 1.5f, 0.0f, -2.0f - (float)(index / 8) * 1.5f };
+    if (instancedPyramids) {
+        // Goes up with the next frame's instance update, no upload of its own
+        const float white[3] = { 1.0f, 1.0f, 1.0f };
+        pyramidInstances.push_back(instancedPyramids->addInstance(InstancedMeshObject::makeInstance(position, 0.0f, 1.0f, white)));
+        return;
+    }
+    auto pyramid = std::make_unique<PyramidObject>();
+    pyramid->setPosition(position[0], position[1], position[2]);
+    requiredUploadValue = std::max(requiredUploadValue, pyramid->createBuffers(*uploadService, *deletionQueue));
+    pyramid->storePreviousTransform();
+    renderObjects.push_back(std::move(pyramid));
+    ++sceneVersion;
+}
+
+void VulkanApp::removeObject(size_t index) {
+    // Frames in flight may still draw it: its buffers outlive the object until they retire
+    renderObjects[index]->releaseBuffers(*deletionQueue);
+    renderObjects.erase(renderObjects.begin() + index);
+    ++sceneVersion;
+}
+
+void VulkanApp::removePyramid() {
+    if (instancedPyramids) {
+        if (pyramidInstances.empty()) return;
+        instancedPyramids->removeInstance(pyramidInstances.back());
+        pyramidInstances.pop_back();
+    } else if (renderObjects.back()->getTopology() == VulkanPipeline::Topology::Triangles) {
+        removeObject(renderObjects.size() - 1);
+    }
+}
+
+void VulkanApp::drawSceneControls() {
+    ImGui::Text("Objects: %u", (unsigned)renderObjects.size());
+    if (!benchmark) {
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Add pyramid")) addPyramid();
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Remove pyramid")) removePyramid();
+        if (instancedPyramids) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Add 1000")) for (int i = 0; i < 1000; ++i) addPyramid();
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Remove 1000")) for (int i = 0; i < 1000; ++i) removePyramid();
+        }
+    }
+    if (gpuCuller) {
+        ImGui::Checkbox("GPU culling", &gpuCulling);
+        if (gpuCulling) {
+            ImGui::SameLine();
+            if (instancedPyramids)
+                ImGui::Text("%u / %u instances drawn", gpuCuller->getStats().drawn, gpuCuller->getStats().submitted);
+            else if (cullsObjects())
+                ImGui::Text("%u / %u objects drawn", gpuCuller->getStats().objectsDrawn, gpuCuller->getStats().objectsSubmitted);
+            else
+                ImGui::TextDisabled("objects: bindless draw path only");
+        }
+    }
+    if (instancedPyramids)
+        ImGui::Text("Instances: %u / %u in 1 draw, %.1f KiB in %u ranges updated last frame", instancedPyramids->getInstanceCount(),
+                    instancedPyramids->getCapacity(), instancedPyramids->getFrameBytes() / 1024.0, instancedPyramids->getFrameRanges());
+    const DeletionStats& stats = deletionQueue->getStats();
+    ImGui::Text("Deletion queue: %u pending (%.1f KiB), pool %u buffers (%.1f KiB), %llu recycled, %llu destroyed",
+                stats.pendingCount, stats.pendingBytes / 1024.0, stats.pooledCount, stats.pooledBytes / 1024.0,
+                (unsigned long long)stats.recycled, (unsigned long long)stats.destroyed);
+}
+
+void VulkanApp::submitUploads() {
+    // Only the first frame that draws new geometry waits for its copies; completed values
+    // need no wait at all, so steady-state frames carry no extra semaphore
+    uploadService->flush();
+    if (requiredUploadValue && !uploadService->isComplete(requiredUploadValue))
+        frameScheduler->waitOnNextSubmit(uploadService->getTimelineSemaphore(), requiredUploadValue,
+                                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    requiredUploadValue = 0;
+}
+
+void VulkanApp::createPipelines() {
+    // One for triangles (pyramid), one for lines (grid)
+    if (pipeline) { delete pipeline; pipeline = nullptr; }
+    if (gridPipeline) { delete gridPipeline; gridPipeline = nullptr; }
+    pipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, descriptorSetLayout, VulkanPipeline::Topology::Triangles);
+    gridPipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, descriptorSetLayout, VulkanPipeline::Topology::Lines);
+    if (instancedPipeline) { delete instancedPipeline; instancedPipeline = nullptr; }
+    instancedPipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, VK_NULL_HANDLE, VulkanPipeline::Topology::Triangles,
+                                           DrawPath::PushConstants, VulkanPipeline::VertexInput::Instanced);
+    // Same pair for the other draw paths, so they can be switched without rebuilding anything
+    if (pushPipeline) { delete pushPipeline; pushPipeline = nullptr; }
+    if (pushGridPipeline) { delete pushGridPipeline; pushGridPipeline = nullptr; }
+    pushPipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, VK_NULL_HANDLE,
+                                      VulkanPipeline::Topology::Triangles, DrawPath::PushConstants);
+    pushGridPipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, VK_NULL_HANDLE,
+                                          VulkanPipeline::Topology::Lines, DrawPath::PushConstants);
+    if (bindlessPipeline) { delete bindlessPipeline; bindlessPipeline = nullptr; }
+    if (bindlessGridPipeline) { delete bindlessGridPipeline; bindlessGridPipeline = nullptr; }
+    if (!transformBuffer) return;
+    bindlessPipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, transformBuffer->getSetLayout(),
+                                          VulkanPipeline::Topology::Triangles, DrawPath::Bindless);
+    bindlessGridPipeline = new VulkanPipeline(vkDevice->getDevice(), renderPass, transformBuffer->getSetLayout(),
+                                              VulkanPipeline::Topology::Lines, DrawPath::Bindless);
+}
+
+VulkanPipeline* VulkanApp::getPipeline(const RenderObject& obj) const {
+    if (obj.getVertexInput() == VulkanPipeline::VertexInput::Instanced) return instancedPipeline;
+    bool lines = obj.getTopology() == VulkanPipeline::Topology::Lines;
+    if (drawPath == DrawPath::Bindless) return lines ? bindlessGridPipeline : bindlessPipeline;
+    if (drawPath == DrawPath::PushConstants) return lines ? pushGridPipeline : pushPipeline;
+    return lines ? gridPipeline : pipeline;
+}
+
+void VulkanApp::drawDrawPathControls(const FrameContext& frame) {
+    if (drawPath == DrawPath::Bindless)
+        ImGui::Text("Transforms: %u / %u MVPs in the frame's SSBO (1 descriptor set per command buffer)",
+                    (unsigned)renderObjects.size(), transformBuffer->getCapacity(frame.slot));
+    else if (drawPath == DrawPath::PushConstants)
+        ImGui::Text("MVPs: %u push constants of 64 B (no buffer write, no descriptor set)", (unsigned)renderObjects.size());
+    else
+        ImGui::Text("Uniform ring: %.1f / %.1f KiB (1 descriptor set per frame, bound per draw)",
+                    frame.uniforms->getUsed() / 1024.0, frame.uniforms->getCapacity() / 1024.0);
+    if (benchmark) return;
+    int path = (int)drawPath;
+    if (transformBuffer) {
+        ImGui::SameLine();
+        ImGui::RadioButton("bindless", &path, (int)DrawPath::Bindless);
+    }
+    ImGui::SameLine();
+    ImGui::RadioButton("ubo", &path, (int)DrawPath::DynamicUBO);
+    ImGui::SameLine();
+    ImGui::RadioButton("push", &path, (int)DrawPath::PushConstants);
+    drawPath = (DrawPath)path;
+}
+
+void VulkanApp::createFrameContexts() {
+    // Recording threads = the main thread + pool workers, capped so per-thread pools stay cheap
+    uint32_t hardwareThreads = std::clamp<uint32_t>(std::thread::hardware_concurrency(), 1, MAX_RECORD_THREADS);
+    workerPool = new WorkerPool(hardwareThreads - 1);
+    // A --bench-threads sweep starts at its first entry (see finishBenchmark)
+    uint32_t requested = (benchmark && !options.benchThreadSweep.empty()) ? options.benchThreadSweep[0] : options.recordThreads;
+    recordThreads = (int)std::min(requested, workerPool->getMaxParallelism());
+    for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; ++slot) {
+        CreateFrameContext(*vkDevice, uniformRingBytes(), FRAME_ARENA_BYTES, workerPool->getMaxParallelism(), frames[slot]);
+        frames[slot].slot = slot;
     }
 }
 
 void VulkanApp::createDescriptorSet() {
-    for (auto& obj : renderObjects) {
-        obj->mvpBuffer = new VulkanBuffer(
-            *vkDevice,
-            vkDevice->getPhysicalDevice(),
-            sizeof(Mat4),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        );
+    // One descriptor set per frame in flight over the whole uniform ring; each draw picks
+    // its MVP with a dynamic offset, so the set count doesn't grow with the scene
+    for (auto& frame : frames) {
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         allocInfo.descriptorPool = uboDescriptorPool; // Use UBO pool
         allocInfo.descriptorSetCount = 1;
         allocInfo.pSetLayouts = &descriptorSetLayout;
-        if (vkAllocateDescriptorSets(vkDevice->getDevice(), &allocInfo, &obj->descriptorSet) != VK_SUCCESS)
+        if (vkAllocateDescriptorSets(vkDevice->getDevice(), &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
             throw std::runtime_error("Failed to allocate descriptor set");
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = obj->mvpBuffer->getBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(Mat4);
-        VkWriteDescriptorSet descriptorWrite{};
-        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet = obj->descriptorSet;
-        descriptorWrite.dstBinding = 0;
-        descriptorWrite.dstArrayElement = 0;
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrite.descriptorCount = 1;
-        descriptorWrite.pBufferInfo = &bufferInfo;
-        vkUpdateDescriptorSets(vkDevice->getDevice(), 1, &descriptorWrite, 0, nullptr);
+        writeFrameDescriptor(frame);
     }
 }
 
+void VulkanApp::writeFrameDescriptor(FrameContext& frame) {
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = frame.uniforms->getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range = sizeof(Mat4); // the window the dynamic offset slides over the ring
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = frame.descriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(vkDevice->getDevice(), 1, &descriptorWrite, 0, nullptr);
+}
+
+void VulkanApp::resizeUniformRing(FrameContext& frame) {
+    // Only called for a context whose last frame has retired, so neither the old ring nor
+    // the descriptor set is in use and both can be replaced directly
+    delete frame.uniforms;
+    frame.uniforms = new UniformRing(*vkDevice, uniformRingBytes());
+    writeFrameDescriptor(frame);
+}
+
+VkDeviceSize VulkanApp::uniformRingBytes() const {
+    // One aligned MVP per object, with headroom for objects added at runtime
+    VkDeviceSize stride = AlignUp(sizeof(Mat4), vkDevice->getProperties().limits.minUniformBufferOffsetAlignment);
+    return stride * std::max<VkDeviceSize>(renderObjects.size() * 2, 64);
+}
+
 void VulkanApp::mainLoop() {
     bool running = true;
-    size_t imageCount = swapchain->getImages().size();
-    uint32_t currentFrame = 0;
     auto lastTime = std::chrono::high_resolution_clock::now();
     while (running) {
+        TRACE_ZONE("frame");
+        // Sleep before sampling input rather than after present, so a capped frame rate
+        // doesn't add the sleep to input latency
+        limitFrameRate();
+        sampleHeapAllocations();
         handleEvents(running);
         if (framebufferResized) {
             recreateSwapchain();
             continue;
         }
-        // Camera movement (was in updateMVPBuffer, now here)
-        float moveSpeed = 0.05f;
-        float forward[3] = { sinf(camYaw) * cosf(camPitch), sinf(camPitch), -cosf(camYaw) * cosf(camPitch) };
-        float right[3] = { cosf(camYaw), 0, sinf(camYaw) };
-        if (keyW) { camX += forward[0] * moveSpeed; camY += forward[1] * moveSpeed; camZ += forward[2] * moveSpeed; }
-        if (keyS) { camX -= forward[0] * moveSpeed; camY -= forward[1] * moveSpeed; camZ -= forward[2] * moveSpeed; }
-        if (keyA) { camX -= right[0] * moveSpeed; camZ -= right[2] * moveSpeed; }
-        if (keyD) { camX += right[0] * moveSpeed; camZ += right[2] * moveSpeed; }
         // FPS calculation
         auto now = std::chrono::high_resolution_clock::now();
         double delta = std::chrono::duration<double>(now - lastTime).count();
@@ -212,24 +464,38 @@ void VulkanApp::mainLoop() {
             frameAccumulator = 0.0;
             frameCount = 0;
         }
-        // Wait for the fence for this frame to be signaled before reusing resources
-        vkWaitForFences(vkDevice->getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-        vkResetFences(vkDevice->getDevice(), 1, &inFlightFences[currentFrame]);
+        // Camera movement and scene animation, in fixed steps
+        updateSimulation(delta);
+        // Wait until frame (ticket - MAX_FRAMES_IN_FLIGHT) has retired before reusing its resources.
+        // Nothing is reset here, so bailing out below just hands out the same ticket next pass.
+        frameScheduler->beginFrame();
+        uploadService->beginFrame();
+        deletionQueue->collect();
+        uint32_t slot = frameScheduler->getFrameSlot();
+        FrameContext& frame = frames[slot];
+        collectGpuTimings(frame, slot);
+        if (gpuCuller) gpuCuller->collect(slot);
+        VkSemaphore imageAvailable = frame.imageAvailable;
         uint32_t imageIndex;
-        VkResult acquireResult = vkAcquireNextImageKHR(
-            vkDevice->getDevice(),
-            swapchain->getSwapchain(),
-            UINT64_MAX,
-            imageAvailableSemaphores[currentFrame],
-            VK_NULL_HANDLE,
-            &imageIndex);
+        VkResult acquireResult;
+        {
+            TRACE_ZONE("acquire");
+            acquireResult = vkAcquireNextImageKHR(
+                vkDevice->getDevice(),
+                swapchain->getSwapchain(),
+                UINT64_MAX,
+                imageAvailable,
+                VK_NULL_HANDLE,
+                &imageIndex);
+        }
         if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
             recreateSwapchain();
             continue;
         } else if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
             throw std::runtime_error("Failed to acquire swapchain image!");
         }
-        vkResetCommandBuffer(commandBuffers[imageIndex], 0);
+        // The frame that last used this context has retired: recycle all its command memory at once
+        vkResetCommandPool(vkDevice->getDevice(), frame.commandPool, 0);
         // Start ImGui frame
         ImGui_ImplVulkan_NewFrame();
         ImGui_ImplSDL2_NewFrame(); // No arguments for latest ImGui
@@ -239,24 +505,41 @@ void VulkanApp::mainLoop() {
         ImGui::SetNextWindowBgAlpha(0.35f);
         ImGui::Begin("FPS", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
         ImGui::Text("FPS: %.1f", fps);
+        double gpuWaitMs = frameScheduler->getLastWaitMs();
+        // Blocked for a sizeable part of the frame -> the GPU is the bottleneck
+        bool gpuBound = gpuWaitMs > 0.25 * delta * 1000.0;
+        ImGui::Text("CPU wait on GPU: %.2f ms (%s-bound)", gpuWaitMs, gpuBound ? "GPU" : "CPU");
+        const UploadStats& uploadStats = uploadService->getStats();
+        ImGui::Text("Uploads (%s): %.1f KiB last frame (%u copies, %u batches), latency %.2f ms (max %.2f)",
+                    uploadService->usesDedicatedQueue() ? "transfer queue" : "graphics queue",
+                    uploadStats.frameBytes / 1024.0, uploadStats.frameCopies, uploadStats.frameBatches,
+                    uploadStats.lastLatencyMs, uploadStats.maxLatencyMs);
+        drawMemoryOverlay();
+        drawAllocationOverlay(frame);
+        const RenderTargetFootprint& rtFootprint = renderTargets->getFootprint();
+        ImGui::Text("Render targets %ux%u: %.1f MiB (%.1f MiB unaliased), lazily allocated: %s",
+                    rtFootprint.extent.width, rtFootprint.extent.height, rtFootprint.committedBytes / 1048576.0,
+                    rtFootprint.requestedBytes / 1048576.0, renderTargets->hasLazyMemory() ? "yes" : "not offered");
+        drawDrawPathControls(frame);
+        drawSceneControls();
+        drawPresentControls();
+        drawGpuProfilerTree();
+        if (benchmark) ImGui::Text("Benchmark: %s", benchmark->getScenario().name.c_str());
         ImGui::End();
         ImGui::Render();
+        applyBenchmarkCamera();
         // Record all drawing (including ImGui) in one command buffer
-        recordCommandBuffer(commandBuffers[imageIndex], imageIndex);
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-        VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = signalSemaphores;
-        if (vkQueueSubmit(vkDevice->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
-            throw std::runtime_error("Failed to submit draw command buffer");
+        recordCommandBuffer(frame, slot, imageIndex);
+        submitUploads();
+        // Signals the timeline with this frame's ticket plus the per-image present semaphore
+        VkSemaphore signalSemaphores[] = { frameScheduler->getRenderFinishedSemaphore(imageIndex) };
+        frameScheduler->submit(
+            vkDevice->getGraphicsQueue(),
+            frame.commandBuffer,
+            imageAvailable,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            signalSemaphores[0]);
+        endBenchmarkFrame(frame, delta * 1000.0);
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         presentInfo.waitSemaphoreCount = 1;
@@ -265,22 +548,401 @@ void VulkanApp::mainLoop() {
         presentInfo.swapchainCount = 1;
         presentInfo.pSwapchains = swapchains;
         presentInfo.pImageIndices = &imageIndex;
-        VkResult presentResult = vkQueuePresentKHR(vkDevice->getPresentQueue(), &presentInfo);
-        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || framebufferResized) {
-            recreateSwapchain();
-            continue;
-        } else if (presentResult != VK_SUCCESS) {
+        VkResult presentResult;
+        {
+            TRACE_ZONE("present");
+            presentResult = vkQueuePresentKHR(vkDevice->getPresentQueue(), &presentInfo);
+        }
+        if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR && presentResult != VK_ERROR_OUT_OF_DATE_KHR)
             throw std::runtime_error("Failed to present swapchain image!");
+        // SUBOPTIMAL still presented the image; OUT_OF_DATE didn't, but the frame was rendered
+        // and submitted (and the present still waited on its semaphore). Either way the frame
+        // counts towards --frames and the benchmark before the swapchain is rebuilt.
+        if (presentResult != VK_ERROR_OUT_OF_DATE_KHR) notePresentForLatency();
+        ++renderedFrames;
+        if (presentResult != VK_SUCCESS || framebufferResized) recreateSwapchain();
+        if (benchmark ? (benchmark->isFinished() && finishBenchmark()) : (options.frames && renderedFrames >= options.frames)) running = false;
+    }
+    // Window closed mid-run: still report what was recorded
+    if (benchmark && !benchmarkDone) finishBenchmark();
+}
+
+void VulkanApp::headlessLoop() {
+    // Same frame pacing as mainLoop, but each frame slot renders into its own offscreen image
+    // and there is nothing to acquire or present. A slot's readback is written out when the
+    // slot comes round again (its frame has retired by then), so the GPU is never drained per frame.
+    auto loopStart = std::chrono::high_resolution_clock::now();
+    auto lastTime = loopStart;
+    while (benchmark ? !benchmarkDone : renderedFrames < options.frames) {
+        TRACE_ZONE("frame");
+        sampleHeapAllocations();
+        auto now = std::chrono::high_resolution_clock::now();
+        double frameMs = std::chrono::duration<double, std::milli>(now - lastTime).count();
+        lastTime = now;
+        updateSimulation(frameMs / 1000.0);
+        frameScheduler->beginFrame();
+        uploadService->beginFrame();
+        deletionQueue->collect();
+        uint32_t slot = frameScheduler->getFrameSlot();
+        FrameContext& frame = frames[slot];
+        collectGpuTimings(frame, slot);
+        if (gpuCuller) gpuCuller->collect(slot);
+        writePendingReadback(slot);
+        vkResetCommandPool(vkDevice->getDevice(), frame.commandPool, 0);
+        applyBenchmarkCamera();
+        recordCommandBuffer(frame, slot, slot);
+        submitUploads();
+        frameScheduler->submit(vkDevice->getGraphicsQueue(), frame.commandBuffer, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+        endBenchmarkFrame(frame, frameMs);
+        pendingReadbacks[slot] = ++renderedFrames;
+        if (benchmark && benchmark->isFinished()) finishBenchmark();
+    }
+    frameScheduler->waitIdle();
+    for (uint32_t slot = 0; slot < pendingReadbacks.size(); ++slot) writePendingReadback(slot);
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - loopStart).count();
+    std::cout << "Rendered " << renderedFrames << " headless frames at " << options.width << "x" << options.height
+              << " in " << seconds * 1000.0 << " ms\n";
+}
+
+void VulkanApp::writePendingReadback(uint32_t imageIndex) {
+    uint64_t frameNumber = pendingReadbacks[imageIndex];
+    pendingReadbacks[imageIndex] = 0;
+    if (frameNumber == 0 || options.outputDir.empty()) return;
+    VkExtent2D extent = offscreenTarget.extent;
+    readbackStaging.resize((size_t)extent.width * extent.height * 4);
+    offscreenTarget.readbackBuffers[imageIndex]->downloadData(readbackStaging.data(), readbackStaging.size());
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05llu.ppm", (unsigned long long)(frameNumber - 1));
+    WriteReadbackPPM((std::filesystem::path(options.outputDir) / name).string().c_str(), readbackStaging.data(), extent);
+}
+
+void VulkanApp::collectGpuTimings(FrameContext& frame, uint32_t slot) {
+    // Called once the frame that last used this slot has retired, so its queries are ready
+    if (!gpuProfiler->collect(slot) || !benchmark) return;
+    benchmark->setGpuTime(frame.benchFrame, gpuProfiler->getFrameMs());
+    benchmark->addGpuScopes(frame.benchFrame, gpuProfiler->getResults());
+}
+
+void VulkanApp::drawMemoryOverlay() {
+    MemoryStats memStats = vkDevice->getAllocator().getStats();
+    ImGui::Text("GPU memory: %.1f / %.1f MiB in %u blocks, %u allocations, %.0f%% fragmented",
+                memStats.usedBytes / 1048576.0, memStats.blockBytes / 1048576.0, memStats.blockCount,
+                memStats.allocationCount, memStats.fragmentation * 100.0);
+    MemoryHeapBudget heaps[VK_MAX_MEMORY_HEAPS];
+    uint32_t heapCount = vkDevice->getMemoryBudget(heaps);
+    // Headline: the most pressured device-local heap. Past ~90% of the budget the driver
+    // starts demoting or evicting allocations, or failing new ones.
+    for (uint32_t i = 0; i < heapCount && vkDevice->hasMemoryBudget(); ++i) {
+        if (!heaps[i].deviceLocal || heaps[i].budget == 0) continue;
+        double pressure = (double)heaps[i].usage / (double)heaps[i].budget;
+        ImVec4 color = pressure > 0.9 ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImVec4(0.6f, 1.0f, 0.6f, 1.0f);
+        ImGui::TextColored(color, "VRAM heap %u: %.1f / %.1f MiB budget (%.0f%%)", i,
+                           heaps[i].usage / 1048576.0, heaps[i].budget / 1048576.0, pressure * 100.0);
+        break;
+    }
+    const DefragStats& defrag = defragmenter->getStats();
+    ImGui::Text("Defrag: %.1f KiB moved last frame (%u buffers), %.2f MiB total, %u sparse blocks",
+                defrag.frameBytes / 1024.0, defrag.frameMoves, defrag.totalBytes / 1048576.0, memStats.sparseBlockCount);
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::SliderInt("Defrag budget (KiB/frame)", &defragBudgetKiB, 0, 4096);
+    if (!ImGui::TreeNode("Memory")) return;
+    for (uint32_t c = 0; c < MEMORY_CATEGORY_COUNT; ++c) {
+        const MemoryCategoryStats& category = memStats.categories[c];
+        if (category.count == 0) continue;
+        ImGui::Text("%-15s %8.2f MiB  (%u)", MemoryCategoryName(static_cast<MemoryCategory>(c)),
+                    category.bytes / 1048576.0, category.count);
+    }
+    ImGui::Text("Peak: %.1f MiB", memStats.peakBytes / 1048576.0);
+    if (!vkDevice->hasMemoryBudget()) ImGui::TextUnformatted("VK_EXT_memory_budget not available");
+    for (uint32_t i = 0; i < heapCount; ++i) {
+        if (vkDevice->hasMemoryBudget())
+            ImGui::Text("Heap %u%s: %.1f / %.1f MiB budget, %.1f MiB heap", i, heaps[i].deviceLocal ? " (device)" : "",
+                        heaps[i].usage / 1048576.0, heaps[i].budget / 1048576.0, heaps[i].size / 1048576.0);
+        else
+            ImGui::Text("Heap %u%s: %.1f MiB", i, heaps[i].deviceLocal ? " (device)" : "", heaps[i].size / 1048576.0);
+    }
+    ImGui::TreePop();
+}
+
+void VulkanApp::sampleHeapAllocations() {
+    uint64_t count = AllocationCounter::GetCount();
+    frameHeapAllocations = count - allocationsAtFrameStart;
+    allocationsAtFrameStart = count;
+}
+
+void VulkanApp::drawAllocationOverlay(const FrameContext& frame) {
+    const FrameArena& arena = *frame.arena;
+    ImVec4 color = frameHeapAllocations ? ImVec4(1.0f, 0.6f, 0.2f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+    ImGui::TextColored(color, "Heap allocations last frame: %llu", (unsigned long long)frameHeapAllocations);
+    ImGui::Text("Frame arena: %.1f / %.1f KiB (high water %.1f KiB, %llu overflows)", arena.getLastFrameBytes() / 1024.0,
+                arena.getCapacity() / 1024.0, arena.getHighWater() / 1024.0, (unsigned long long)arena.getOverflowCount());
+#if FRAME_ARENA_DEBUG
+    if (arena.getTagCount() && ImGui::TreeNode("Frame arena tags")) {
+        for (uint32_t i = 0; i < arena.getTagCount(); ++i)
+            ImGui::Text("%-16s high water %.1f KiB", arena.getTag(i).tag, arena.getTag(i).highWater / 1024.0);
+        ImGui::TreePop();
+    }
+#endif
+}
+
+void VulkanApp::drawGpuProfilerTree() {
+    if (!gpuProfiler->isEnabled() || gpuProfiler->getResults().empty()) return;
+    ImGui::Text("GPU frame: %.2f ms", gpuProfiler->getFrameMs());
+    if (!ImGui::TreeNode("GPU scopes")) return;
+    // Results are pre-order with depths; open a tree node per scope and pop back up as depth drops
+    const auto& results = gpuProfiler->getResults();
+    uint32_t openDepth = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const GpuScopeResult& r = results[i];
+        if (r.depth > openDepth) continue; // parent collapsed
+        while (openDepth > r.depth) { ImGui::TreePop(); --openDepth; }
+        bool hasChildren = i + 1 < results.size() && results[i + 1].depth > r.depth;
+        ImGuiTreeNodeFlags flags = hasChildren ? 0 : (ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen);
+        bool open = r.index >= 0
+            ? ImGui::TreeNodeEx((void*)(intptr_t)i, flags, "%s[%d]  %.3f ms", r.name, r.index, r.ms)
+            : ImGui::TreeNodeEx((void*)(intptr_t)i, flags, "%s  %.3f ms", r.name, r.ms);
+        if (open && hasChildren) ++openDepth;
+    }
+    while (openDepth > 0) { ImGui::TreePop(); --openDepth; }
+    ImGui::TreePop();
+}
+
+void VulkanApp::updateSimulation(double elapsedSeconds) {
+    TRACE_ZONE("simulation");
+    // Benchmarks and headless runs advance exactly one step per frame, so what ends up on
+    // screen depends on the frame number only, never on how fast frames were produced
+    bool deterministic = benchmark || options.headless;
+    uint32_t steps = simClock.advance(deterministic ? simClock.getStepSeconds() : elapsedSeconds);
+    for (uint32_t i = 0; i < steps; ++i) {
+        prevCamX = camX; prevCamY = camY; prevCamZ = camZ;
+        for (auto& obj : renderObjects) obj->storePreviousTransform();
+        simulationStep((float)simClock.getStepSeconds());
+    }
+    renderAlpha = deterministic ? 1.0f : simClock.getAlpha();
+}
+
+void VulkanApp::simulationStep(float dt) {
+    // Camera movement (WASD); the benchmark drives the camera itself
+    if (!benchmark) {
+        float moveSpeed = 3.0f * dt; // units per second
+        float forward[3] = { sinf(camYaw) * cosf(camPitch), sinf(camPitch), -cosf(camYaw) * cosf(camPitch) };
+        float right[3] = { cosf(camYaw), 0, sinf(camYaw) };
+        if (keyW) { camX += forward[0] * moveSpeed; camY += forward[1] * moveSpeed; camZ += forward[2] * moveSpeed; }
+        if (keyS) { camX -= forward[0] * moveSpeed; camY -= forward[1] * moveSpeed; camZ -= forward[2] * moveSpeed; }
+        if (keyA) { camX -= right[0] * moveSpeed; camZ -= right[2] * moveSpeed; }
+        if (keyD) { camX += right[0] * moveSpeed; camZ += right[2] * moveSpeed; }
+    }
+    // Scene animation: pyramids spin slowly about Y (angle kept in [-pi, pi])
+    for (auto& obj : renderObjects) {
+        if (obj->getTopology() != VulkanPipeline::Topology::Triangles ||
+            obj->getVertexInput() == VulkanPipeline::VertexInput::Instanced) continue;
+        const float* r = obj->getRotation();
+        obj->setRotation(r[0], std::remainder(r[1] + 0.5f * dt, 6.2831853f), r[2]);
+    }
+    if (!instancedPyramids) return;
+    // Instanced: only the first few spin, as incremental instance updates (not interpolated)
+    instanceSpin = std::remainder(instanceSpin + 0.5f * dt, 6.2831853f);
+    uint32_t animated = std::min<uint32_t>((uint32_t)pyramidInstances.size(), ANIMATED_INSTANCES);
+    for (uint32_t i = 0; i < animated; ++i) {
+        const InstanceData& current = instancedPyramids->getInstance(pyramidInstances[i]);
+        float position[3] = { current.model[0][3], current.model[1][3], current.model[2][3] };
+        instancedPyramids->updateInstance(pyramidInstances[i], InstancedMeshObject::makeInstance(position, instanceSpin, 1.0f, current.color));
+    }
+}
+
+void VulkanApp::applyBenchmarkCamera() {
+    if (!benchmark) return;
+    CameraPose pose = benchmark->getCameraPose();
+    camX = prevCamX = pose.x; camY = prevCamY = pose.y; camZ = prevCamZ = pose.z;
+    camYaw = pose.yaw; camPitch = pose.pitch;
+}
+
+void VulkanApp::endBenchmarkFrame(FrameContext& frame, double frameMs) {
+    if (!benchmark) return;
+    frame.benchFrame = benchmark->endFrame(frameMs, frameScheduler->getLastWaitMs(), recordMs, frameHeapAllocations);
+}
+
+bool VulkanApp::finishBenchmark() {
+    if (!benchmark || benchmarkDone) return true;
+    // Collect the timestamps of the frames still in flight before reporting
+    frameScheduler->waitIdle();
+    for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; ++slot) {
+        collectGpuTimings(frames[slot], slot);
+        if (gpuCuller) gpuCuller->collect(slot);
+    }
+    BenchReportInfo info;
+    info.deviceName = vkDevice->getProperties().deviceName;
+    info.width = getRenderExtent().width;
+    info.height = getRenderExtent().height;
+    info.presentMode = swapchain ? PresentModeName(swapchain->getPresentMode()) : "headless";
+    if (fpsLimit > 0) info.presentMode += "+limit" + std::to_string(fpsLimit);
+    info.validation = options.enableValidation;
+    info.objectCount = renderObjects.size();
+    info.instanceCount = instancedPyramids ? instancedPyramids->getInstanceCount() : 0;
+    info.gpuCulling = gpuCuller && gpuCulling;
+    if (info.gpuCulling) {
+        info.cullSubmitted = gpuCuller->getStats().submitted;
+        info.cullDrawn = gpuCuller->getStats().drawn;
+        info.cullObjectsSubmitted = gpuCuller->getStats().objectsSubmitted;
+        info.cullObjectsDrawn = gpuCuller->getStats().objectsDrawn;
+    }
+    info.recordThreads = (uint32_t)recordThreads;
+    info.drawSort = sortDraws;
+    info.binds = drawBindStats;
+    info.drawPath = DrawPathName(drawPath);
+    for (const RenderTargetFootprint& f : renderTargets->getFootprintHistory())
+        info.renderTargets.push_back({ f.extent.width, f.extent.height, f.committedBytes, f.requestedBytes, f.lazyBytes });
+    MemoryStats memStats = vkDevice->getAllocator().getStats();
+    for (uint32_t c = 0; c < MEMORY_CATEGORY_COUNT; ++c)
+        info.memoryCategories.push_back({ MemoryCategoryName(static_cast<MemoryCategory>(c)), memStats.categories[c].bytes, memStats.categories[c].count });
+    MemoryHeapBudget heaps[VK_MAX_MEMORY_HEAPS];
+    uint32_t heapCount = vkDevice->getMemoryBudget(heaps);
+    for (uint32_t i = 0; i < heapCount; ++i)
+        info.memoryHeaps.push_back({ heaps[i].size, heaps[i].budget, heaps[i].usage, heaps[i].deviceLocal });
+    info.memoryBudgetExtension = vkDevice->hasMemoryBudget();
+    info.memoryPeakBytes = memStats.peakBytes;
+    info.memoryFragmentation = memStats.fragmentation;
+    info.memorySparseBlocks = memStats.sparseBlockCount;
+    info.defragMovedBytes = defragmenter->getStats().totalBytes;
+    for (const FrameContext& frame : frames) {
+        info.frameArenaHighWater = std::max<uint64_t>(info.frameArenaHighWater, frame.arena->getHighWater());
+        info.frameArenaOverflows += frame.arena->getOverflowCount();
+    }
+    if (benchmarkSweepRuns() == 0) {
+        benchmark->writeReport(options.benchReport, info);
+        benchmarkDone = true;
+        return true;
+    }
+    // --bench-threads / --bench-draw-paths: rerun the same camera path once per entry, then write all runs
+    sweepReports.push_back(benchmark->buildReport(info));
+    if (benchmark->isFinished() && sweepReports.size() < benchmarkSweepRuns()) {
+        applyBenchmarkSweepRun(sweepReports.size());
+        BenchScenario scenario = benchmark->getScenario();
+        delete benchmark;
+        benchmark = new Benchmark(scenario, options.warmupFrames, options.frames);
+        return false;
+    }
+    std::string json = options.benchThreadSweep.empty() ? "{\n\"sweep\": \"draw_path\",\n\"runs\": [\n"
+                                                        : "{\n\"sweep\": \"record_threads\",\n\"runs\": [\n";
+    for (size_t i = 0; i < sweepReports.size(); ++i) json += (i ? ",\n" : "") + sweepReports[i];
+    json += "]\n}\n";
+    WriteBenchReport(options.benchReport, json);
+    benchmarkDone = true;
+    return true;
+}
+
+size_t VulkanApp::benchmarkSweepRuns() const {
+    return options.benchThreadSweep.empty() ? options.benchDrawPathSweep.size() : options.benchThreadSweep.size();
+}
+
+void VulkanApp::applyBenchmarkSweepRun(size_t run) {
+    if (!options.benchThreadSweep.empty())
+        recordThreads = (int)std::min(options.benchThreadSweep[run], workerPool->getMaxParallelism());
+    else
+        drawPath = supportedDrawPath(options.benchDrawPathSweep[run]);
+}
+
+DrawPath VulkanApp::supportedDrawPath(DrawPath requested) const {
+    if (requested != DrawPath::Bindless || transformBuffer) return requested;
+    std::cerr << "Descriptor indexing not supported, using the dynamic UBO draw path\n";
+    return DrawPath::DynamicUBO;
+}
+
+void VulkanApp::limitFrameRate() {
+    if (fpsLimit <= 0) return;
+    TRACE_ZONE("frameLimiter");
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fpsLimit));
+    auto now = std::chrono::steady_clock::now();
+    // First frame, or more than a frame behind: restart the schedule instead of bursting to catch up
+    if (nextFrameStart.time_since_epoch().count() == 0 || now - nextFrameStart > period)
+        nextFrameStart = now;
+    // OS sleeps overshoot by up to a millisecond or two, so sleep short and spin the rest
+    auto spinMargin = std::chrono::milliseconds(2);
+    if (nextFrameStart - now > spinMargin) std::this_thread::sleep_until(nextFrameStart - spinMargin);
+    while (std::chrono::steady_clock::now() < nextFrameStart) std::this_thread::yield();
+    nextFrameStart += period;
+}
+
+void VulkanApp::notePresentForLatency() {
+    auto now = std::chrono::steady_clock::now();
+    if (inputPending) {
+        inputLatencyMs = std::chrono::duration<double, std::milli>(now - pendingInputTime).count();
+        inputPending = false;
+        latencyAccumMs += inputLatencyMs;
+        latencyWindowMaxMs = std::max(latencyWindowMaxMs, inputLatencyMs);
+        ++latencySamples;
+    }
+    // Publish avg/max once a second, like the FPS counter
+    if (now - latencyWindowStart >= std::chrono::seconds(1)) {
+        if (latencySamples > 0) {
+            inputLatencyAvgMs = latencyAccumMs / latencySamples;
+            inputLatencyMaxMs = latencyWindowMaxMs;
+        }
+        latencyAccumMs = latencyWindowMaxMs = 0.0;
+        latencySamples = 0;
+        latencyWindowStart = now;
+    }
+}
+
+void VulkanApp::drawPresentControls() {
+    ImGui::Text("Input->present: %.1f ms (avg %.1f, max %.1f)", inputLatencyMs, inputLatencyAvgMs, inputLatencyMaxMs);
+    const VkPresentModeKHR modes[] = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+    const auto& supported = swapchain->getSupportedPresentModes();
+    ImGui::SetNextItemWidth(140.0f);
+    if (ImGui::BeginCombo("Present mode", PresentModeName(swapchain->getPresentMode()))) {
+        for (VkPresentModeKHR mode : modes) {
+            bool available = std::find(supported.begin(), supported.end(), mode) != supported.end();
+            ImGui::BeginDisabled(!available);
+            if (ImGui::Selectable(PresentModeName(mode), mode == swapchain->getPresentMode()) && mode != swapchain->getPresentMode()) {
+                requestedPresentMode = mode;
+                framebufferResized = true; // picked up by the swapchain recreation path after present
+            }
+            ImGui::EndDisabled();
         }
-        // Advance to next frame in flight
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        ImGui::EndCombo();
     }
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::SliderInt("FPS limit", &fpsLimit, 0, 360, fpsLimit > 0 ? "%d" : "off");
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::SliderInt("Record threads", &recordThreads, 0, (int)workerPool->getMaxParallelism(), recordThreads > 0 ? "%d" : "inline");
+    ImGui::Text("Record: %.3f ms", recordMs);
+    ImGui::Checkbox("Sort draws", &sortDraws);
+    ImGui::Text("Binds: %u pipeline, %u vertex, %u index for %u draws", drawBindStats.pipelineBinds,
+                drawBindStats.vertexBufferBinds, drawBindStats.indexBufferBinds, drawBindStats.draws);
+}
+
+void VulkanApp::dumpCpuTrace() {
+    std::string path = options.traceFile.empty() ? "vulkanrays_trace.json" : options.traceFile;
+    if (CpuTrace::DumpChromeTrace(path, options.traceSeconds))
+        std::cout << "Wrote CPU trace (last " << options.traceSeconds << " s) to " << path << "\n";
+    else
+        std::cerr << "Failed to write CPU trace to " << path << "\n";
+}
+
+VkExtent2D VulkanApp::getRenderExtent() const {
+    return swapchain ? swapchain->getExtent() : offscreenTarget.extent;
+}
+
+VkFormat VulkanApp::getColorFormat() const {
+    return swapchain ? swapchain->getImageFormat() : offscreenTarget.format;
+}
+
+const std::vector<VkImageView>& VulkanApp::getColorImageViews() const {
+    return swapchain ? swapchain->getImageViews() : offscreenTarget.imageViews;
 }
 
 void VulkanApp::handleEvents(bool& running) {
+    TRACE_ZONE("handleEvents");
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         ImGui_ImplSDL2_ProcessEvent(&event); // Pass events to ImGui
+        bool isInput = event.type == SDL_KEYDOWN || event.type == SDL_MOUSEMOTION || event.type == SDL_MOUSEBUTTONDOWN;
+        if (isInput && !inputPending) {
+            // SDL timestamps are ms since SDL_Init; convert to steady_clock via the current lag
+            Uint32 ageMs = SDL_GetTicks() - event.common.timestamp;
+            pendingInputTime = std::chrono::steady_clock::now() - std::chrono::milliseconds(ageMs);
+            inputPending = true;
+        }
         if (event.type == SDL_QUIT) running = false;
         else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
             framebufferResized = true;
@@ -292,6 +954,9 @@ void VulkanApp::handleEvents(bool& running) {
                 case SDL_SCANCODE_A: keyA = down; break;
                 case SDL_SCANCODE_S: keyS = down; break;
                 case SDL_SCANCODE_D: keyD = down; break;
+                case SDL_SCANCODE_F9:
+                    if (down && !event.key.repeat) dumpCpuTrace();
+                    break;
                 case SDL_SCANCODE_ESCAPE:
                     if (down && mouseCaptured) {
                         SDL_SetRelativeMouseMode(SDL_FALSE);
@@ -323,7 +988,7 @@ void VulkanApp::handleEvents(bool& running) {
 void VulkanApp::createDescriptorSetLayout() {
     VkDescriptorSetLayoutBinding uboLayoutBinding{};
     uboLayoutBinding.binding = 0;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     uboLayoutBinding.descriptorCount = 1;
     uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     uboLayoutBinding.pImmutableSamplers = nullptr;
@@ -334,33 +999,21 @@ void VulkanApp::createDescriptorSetLayout() {
     if (vkCreateDescriptorSetLayout(vkDevice->getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create descriptor set layout");
 }
-void VulkanApp::createDescriptorPool() {
-    size_t numObjects = renderObjects.size();
-    VkDescriptorPoolSize poolSize{};
-    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSize.descriptorCount = static_cast<uint32_t>(numObjects);
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
-    poolInfo.maxSets = static_cast<uint32_t>(numObjects);
-    if (vkCreateDescriptorPool(vkDevice->getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create descriptor pool");
-}
 void VulkanApp::updateMVPBuffer() {
     // No-op: all per-object MVP buffer updates are handled in recordCommandBuffer()
 }
 
 void VulkanApp::createRenderPass() {
     VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapchain->getImageFormat();
+    colorAttachment.format = getColorFormat();
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // Headless frames are copied out to a readback buffer instead of presented
+    colorAttachment.finalLayout = options.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = depthResources.format; // Use modularized depth format
@@ -386,6 +1039,23 @@ void VulkanApp::createRenderPass() {
     subpass.pColorAttachments = &colorAttachmentRef;
     subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
+    // The depth image is shared by all frames in flight: order this frame's depth clear after
+    // the previous frame's depth writes. Headless also orders the final layout transition
+    // before the readback copy.
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
     VkAttachmentDescription attachments[2] = { colorAttachment, depthAttachment };
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -393,11 +1063,13 @@ void VulkanApp::createRenderPass() {
     renderPassInfo.pAttachments = attachments;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = options.headless ? 2 : 1;
+    renderPassInfo.pDependencies = dependencies;
     if (vkCreateRenderPass(vkDevice->getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
         throw std::runtime_error("Failed to create render pass");
 }
 void VulkanApp::createFramebuffers() {
-    auto& views = swapchain->getImageViews();
+    auto& views = getColorImageViews();
     framebuffers.resize(views.size());
     VkImageView depthView = depthResources.view;
     for (size_t i = 0; i < views.size(); ++i) {
@@ -407,42 +1079,75 @@ void VulkanApp::createFramebuffers() {
         fbInfo.renderPass = renderPass;
         fbInfo.attachmentCount = 2;
         fbInfo.pAttachments = attachments;
-        fbInfo.width = swapchain->getExtent().width;
-        fbInfo.height = swapchain->getExtent().height;
+        fbInfo.width = getRenderExtent().width;
+        fbInfo.height = getRenderExtent().height;
         fbInfo.layers = 1;
         if (vkCreateFramebuffer(vkDevice->getDevice(), &fbInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
             throw std::runtime_error("Failed to create framebuffer");
     }
 }
-void VulkanApp::createCommandPool() {
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = vkDevice->getGraphicsQueueFamily();
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    if (vkCreateCommandPool(vkDevice->getDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create command pool");
-}
-void VulkanApp::createCommandBuffers() {
-    commandBuffers.resize(framebuffers.size());
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
-    if (vkAllocateCommandBuffers(vkDevice->getDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
-        throw std::runtime_error("Failed to allocate command buffers");
-}
 void VulkanApp::createSyncObjects() {
-    syncObjects = {};
-    CreateSyncObjects(vkDevice->getDevice(), MAX_FRAMES_IN_FLIGHT, syncObjects);
-    imageAvailableSemaphores = syncObjects.imageAvailableSemaphores;
-    renderFinishedSemaphores = syncObjects.renderFinishedSemaphores;
-    inFlightFences = syncObjects.inFlightFences;
+    frameScheduler = new FrameScheduler(vkDevice->getDevice(), MAX_FRAMES_IN_FLIGHT);
+    if (swapchain) frameScheduler->resizeRenderFinishedSemaphores(swapchain->getImages().size());
 }
-void VulkanApp::recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex) {
+void VulkanApp::recordCommandBuffer(FrameContext& frame, uint32_t slot, uint32_t imageIndex) {
+    TRACE_ZONE("recordCommandBuffer");
+    auto recordStart = std::chrono::steady_clock::now();
+    // Objects were added since this context's ring was sized
+    if (AlignUp(sizeof(Mat4), frame.uniforms->getAlignment()) * renderObjects.size() > frame.uniforms->getCapacity())
+        resizeUniformRing(frame);
+    VkCommandBuffer cmd = frame.commandBuffer;
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(cmd, &beginInfo);
+    // The frame that last used this context has retired
+    frame.uniforms->reset();
+    frame.arena->reset();
+    gpuProfiler->beginFrame(cmd, slot);
+    {
+        // Buffer moves land before the render pass; draws below already bind the new copies
+        GpuScope defragScope(defragBudgetKiB > 0 ? gpuProfiler : nullptr, cmd, "defrag");
+        defragmenter->step(cmd, (VkDeviceSize)defragBudgetKiB << 10);
+    }
+    {
+        // Instance changes since the last frame (after the moves, so they target the new copies)
+        GpuScope instanceScope(instancedPyramids ? gpuProfiler : nullptr, cmd, "instance updates");
+        for (auto& obj : renderObjects) obj->recordUpdates(cmd, frame.slot, *uploadService, *deletionQueue);
+    }
+    Mat4 viewProj = computeViewProj();
+    // All MVPs up front into the frame arena; culling, sorting and recording (possibly on
+    // workers) read them from there. Bindless copies them into the frame's transform buffer in
+    // one go: that memory may be write-combined, so it is only ever written, never read back.
+    bool bindless = drawPath == DrawPath::Bindless;
+    uint32_t objectCount = (uint32_t)renderObjects.size();
+    Mat4* mvps = frame.arena->allocateArray<Mat4>(objectCount, "object mvps");
+    for (uint32_t i = 0; i < objectCount; ++i)
+        mvps[i] = mat4_mul(viewProj, renderObjects[i]->getInterpolatedModelMatrix(renderAlpha));
+    if (bindless) std::memcpy(transformBuffer->map(frame.slot, objectCount), mvps, objectCount * sizeof(Mat4));
+    cullDraws = DrawBinding{};
+    if (gpuCuller && gpuCulling && instancedPyramids) {
+        // Survivors and their count come out of a compute pass; the draw reads both straight
+        // from the GPU, so recording costs the same at 10 or a million instances
+        GpuScope cullScope(gpuProfiler, cmd, "cull");
+        Mat4 mvp = mat4_mul(viewProj, instancedPyramids->getInterpolatedModelMatrix(renderAlpha));
+        gpuCuller->record(cmd, frame.slot, *instancedPyramids, mvp, *deletionQueue, cullDraws);
+    }
+    bool objectCulling = cullsObjects();
+    if (objectCulling) {
+        // The plain objects go the same way, one indirect-count draw per mesh
+        GpuScope cullScope(gpuProfiler, cmd, "cull objects");
+        gpuCuller->recordObjects(cmd, frame.slot, renderObjects, sceneVersion, *transformBuffer, *deletionQueue);
+    }
+    // Only what GPU culling leaves out goes through the draw list
+    const uint32_t* listed = objectCulling ? gpuCuller->getUnculledObjects().data() : nullptr;
+    uint32_t packetCount = objectCulling ? (uint32_t)gpuCuller->getUnculledObjects().size() : objectCount;
+    DrawPacket* packets = buildDrawList(frame, mvps, listed, packetCount);
+    uint32_t passScope = gpuProfiler->beginScope(cmd, "render pass");
+    // Parallel path: the subpass consists only of secondary command buffers. The culled
+    // batches are a few commands, recorded inline.
+    uint32_t threads = std::min<uint32_t>((uint32_t)recordThreads, (uint32_t)frame.secondaryCommandBuffers.size());
+    bool parallel = threads > 0 && packetCount > 0 && !objectCulling;
     VkClearValue clearValues[2];
     clearValues[0].color = { {0.1f, 0.1f, 0.1f, 1.0f} };
     clearValues[1].depthStencil = { 1.0f, 0 };
@@ -451,32 +1156,221 @@ void VulkanApp::recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex) {
     rpInfo.renderPass = renderPass;
     rpInfo.framebuffer = framebuffers[imageIndex];
     rpInfo.renderArea.offset = {0, 0};
-    rpInfo.renderArea.extent = swapchain->getExtent();
+    rpInfo.renderArea.extent = getRenderExtent();
     rpInfo.clearValueCount = 2;
     rpInfo.pClearValues = clearValues;
-    vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
-    // Modular: draw all render objects
-    int w = (int)swapchain->getExtent().width, h = (int)swapchain->getExtent().height;
+    vkCmdBeginRenderPass(cmd, &rpInfo, parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+    if (parallel) {
+        recordObjectsParallel(frame, imageIndex, packets, packetCount, mvps, threads);
+    } else {
+        setViewportAndScissor(cmd);
+        drawBindStats = DrawBindStats{};
+        if (objectCulling) recordObjectBatches(cmd, frame, drawBindStats);
+        recordObjectRange(cmd, frame, packets, 0, packetCount, mvps, true, drawBindStats);
+        if (!options.headless) {
+            GpuScope imguiScope(gpuProfiler, cmd, "imgui");
+            recordImGui(cmd);
+        }
+    }
+    vkCmdEndRenderPass(cmd);
+    gpuProfiler->endScope(cmd, passScope);
+    // Per-object MVPs were written straight into this frame's uniform ring (frames still in
+    // flight keep theirs); one flush covers all non-coherent writes of the frame
+    frame.uniforms->finish();
+    if (bindless) transformBuffer->finish(frame.slot, objectCount);
+    vkDevice->getAllocator().flushPending();
+    if (options.headless) {
+        GpuScope readbackScope(gpuProfiler, cmd, "readback");
+        RecordOffscreenReadback(cmd, offscreenTarget, imageIndex);
+    }
+    vkEndCommandBuffer(cmd);
+    recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+}
+
+Mat4 VulkanApp::computeViewProj() const {
+    int w = (int)getRenderExtent().width, h = (int)getRenderExtent().height;
     float aspect = w / (float)h;
     Mat4 proj = perspective(1.0f, aspect, 0.1f, 100.0f);
-    float eyeX = camX, eyeY = camY, eyeZ = camZ;
+    // Position is blended between the last two simulation steps; orientation comes straight
+    // from the mouse so looking around has no added latency
+    float eyeX = prevCamX + (camX - prevCamX) * renderAlpha;
+    float eyeY = prevCamY + (camY - prevCamY) * renderAlpha;
+    float eyeZ = prevCamZ + (camZ - prevCamZ) * renderAlpha;
     float forward[3] = { sinf(camYaw) * cosf(camPitch), sinf(camPitch), -cosf(camYaw) * cosf(camPitch) };
-    float centerX = camX + forward[0], centerY = camY + forward[1], centerZ = camZ + forward[2];
+    float centerX = eyeX + forward[0], centerY = eyeY + forward[1], centerZ = eyeZ + forward[2];
     float upX = 0, upY = 1, upZ = 0;
     Mat4 view = lookAt(eyeX, eyeY, eyeZ, centerX, centerY, centerZ, upX, upY, upZ);
-    for (auto& obj : renderObjects) {
-        VulkanPipeline* usedPipeline = (obj->getTopology() == VulkanPipeline::Topology::Lines) ? gridPipeline : pipeline;
-        if (usedPipeline) {
-            // Per-object MVP
-            Mat4 model = obj->getModelMatrix();
-            Mat4 mvp = mat4_mul(proj, mat4_mul(view, model));
-            obj->mvpBuffer->uploadData(&mvp, sizeof(Mat4));
-            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, usedPipeline->getGraphicsPipeline());
-            obj->recordDraw(cmd, usedPipeline->getPipelineLayout(), obj->descriptorSet);
+    return mat4_mul(proj, view);
+}
+
+void VulkanApp::setViewportAndScissor(VkCommandBuffer cmd) const {
+    VkViewport viewport{};
+    viewport.width = (float)getRenderExtent().width;
+    viewport.height = (float)getRenderExtent().height;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{ {0, 0}, getRenderExtent() };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
+
+DrawPacket* VulkanApp::buildDrawList(FrameContext& frame, const Mat4* mvps, const uint32_t* objects, uint32_t count) {
+    TRACE_ZONE("buildDrawList");
+    DrawPacket* packets = frame.arena->allocateArray<DrawPacket>(count, "draw packets");
+    for (uint32_t i = 0; i < count; ++i) packets[i].object = objects ? objects[i] : i;
+    if (!sortDraws) return packets;
+    // Pipeline ids in order of first use; a frame uses three at most (triangles, lines,
+    // instanced), anything past the table shares the last id
+    const VulkanPipeline* pipelineIds[8] = {};
+    uint32_t pipelineCount = 0;
+    for (uint32_t p = 0; p < count; ++p) {
+        uint32_t i = packets[p].object;
+        const RenderObject& obj = *renderObjects[i];
+        const VulkanPipeline* objPipeline = getPipeline(obj);
+        uint32_t id = 0;
+        while (id < pipelineCount && pipelineIds[id] != objPipeline) ++id;
+        if (id == pipelineCount && pipelineCount < 8) pipelineIds[pipelineCount++] = objPipeline;
+        id = std::min<uint32_t>(id, 7);
+        // mvps[i].m[15] is the clip-space w of the object's origin: its distance along the view axis
+        packets[p].key = MakeDrawKey(id, MeshSortId(obj.getMeshBuffers().vertex[0]), 0, mvps[i].m[15]);
+    }
+    DrawPacket* scratch = frame.arena->allocateArray<DrawPacket>(count, "draw sort scratch");
+    SortDrawPackets(packets, scratch, count);
+    return packets;
+}
+
+void VulkanApp::recordObjectRange(VkCommandBuffer cmd, FrameContext& frame, const DrawPacket* packets, size_t begin, size_t end,
+                                  const Mat4* mvps, bool profileDraws, DrawBindStats& stats) {
+    // UBO path: bump-allocates each object's MVP from the frame's uniform ring and binds it per
+    // draw. Bindless: the MVPs are already in the transform buffer; one bind for the whole
+    // range, then each draw only says which MVP is its own. Push constants: each draw pushes
+    // its MVP straight from the frame arena. Instanced objects always push theirs through a
+    // layout without the transform set, which disturbs both the set and the slot push
+    // constant, so bind() runs again after one.
+    // With sortDraws the pipeline and mesh buffers are only bound when they change (vertex
+    // and index bindings survive pipeline binds); without it every draw binds everything.
+    bool bindless = drawPath == DrawPath::Bindless;
+    bool bindlessBound = false;
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    MeshBuffers boundMesh;
+    for (size_t p = begin; p < end; ++p) {
+        uint32_t i = packets[p].object;
+        auto& obj = renderObjects[i];
+        VulkanPipeline* usedPipeline = getPipeline(*obj);
+        bool instanced = obj->getVertexInput() == VulkanPipeline::VertexInput::Instanced;
+        DrawBinding binding;
+        binding.layout = usedPipeline->getPipelineLayout();
+        if (instanced) {
+            binding.pushMvp = &mvps[i];
+            binding.indirectBuffer = cullDraws.indirectBuffer; // null unless GpuCuller ran this frame
+            binding.indirectInstances = cullDraws.indirectInstances;
+            bindlessBound = false;
+        } else if (bindless) {
+            if (!bindlessBound) transformBuffer->bind(cmd, binding.layout, frame.slot);
+            bindlessBound = true;
+            binding.firstInstance = (uint32_t)i;
+        } else if (drawPath == DrawPath::PushConstants) {
+            binding.pushMvp = &mvps[i];
+        } else {
+            UniformSlice slice = frame.uniforms->allocate(sizeof(Mat4));
+            std::memcpy(slice.data, &mvps[i], sizeof(Mat4));
+            binding.descriptorSet = frame.descriptorSet;
+            binding.uniformOffset = slice.offset;
         }
+        bool lines = obj->getTopology() == VulkanPipeline::Topology::Lines;
+        GpuScope drawScope(profileDraws ? gpuProfiler : nullptr, cmd, instanced ? "instances" : lines ? "grid" : "pyramid", (int32_t)i);
+        VkPipeline objPipeline = usedPipeline->getGraphicsPipeline();
+        if (!sortDraws || objPipeline != boundPipeline) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, objPipeline);
+            boundPipeline = objPipeline;
+            ++stats.pipelineBinds;
+        }
+        MeshBuffers mesh = obj->getMeshBuffers();
+        if (binding.indirectInstances) mesh.vertex[1] = binding.indirectInstances;
+        binding.bindVertexBuffers = !sortDraws || mesh.vertex[0] != boundMesh.vertex[0] || mesh.vertex[1] != boundMesh.vertex[1];
+        binding.bindIndexBuffer = !sortDraws || mesh.index != boundMesh.index;
+        stats.vertexBufferBinds += binding.bindVertexBuffers;
+        stats.indexBufferBinds += binding.bindIndexBuffer;
+        ++stats.draws;
+        boundMesh = mesh;
+        obj->recordDraw(cmd, binding);
     }
-    vkCmdEndRenderPass(cmd);
-    vkEndCommandBuffer(cmd);
+}
+
+bool VulkanApp::cullsObjects() const {
+    return gpuCuller && gpuCulling && gpuCuller->cullsObjects() && drawPath == DrawPath::Bindless;
+}
+
+void VulkanApp::recordObjectBatches(VkCommandBuffer cmd, FrameContext& frame, DrawBindStats& stats) {
+    // One vkCmdDrawIndexedIndirectCount per batch: commands and count come from the cull pass.
+    // The bindless pipelines share a layout, so the transform set bound once stays valid.
+    const std::vector<ObjectBatch>& batches = gpuCuller->getObjectBatches();
+    for (uint32_t b = 0; b < (uint32_t)batches.size(); ++b) {
+        RenderObject& obj = *renderObjects[batches[b].object];
+        VulkanPipeline* usedPipeline = getPipeline(obj);
+        DrawBinding binding;
+        binding.layout = usedPipeline->getPipelineLayout();
+        gpuCuller->bindObjectBatch(b, binding);
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, usedPipeline->getGraphicsPipeline());
+        if (b == 0) transformBuffer->bind(cmd, binding.layout, frame.slot);
+        ++stats.pipelineBinds;
+        ++stats.vertexBufferBinds;
+        ++stats.indexBufferBinds;
+        ++stats.draws;
+        GpuScope drawScope(gpuProfiler, cmd, "culled objects", (int32_t)b);
+        obj.recordDraw(cmd, binding);
+    }
+}
+
+void VulkanApp::recordObjectsParallel(FrameContext& frame, uint32_t imageIndex, const DrawPacket* packets, uint32_t packetCount, const Mat4* mvps,
+                                      uint32_t threads) {
+    // Each worker owns one command pool + secondary buffer per frame context, so no pool is
+    // ever touched by two threads. Per-draw GPU scopes are skipped here (GpuProfiler isn't
+    // thread-safe); the render pass and ImGui scopes still work.
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = renderPass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = framebuffers[imageIndex];
+    VkCommandBufferBeginInfo secondaryBegin{};
+    secondaryBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    secondaryBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    secondaryBegin.pInheritanceInfo = &inheritance;
+    size_t objectCount = packetCount;
+    threads = std::min<uint32_t>(threads, packetCount);
+    // Each worker starts with nothing bound and counts its own binds
+    DrawBindStats* workerStats = frame.arena->allocateArray<DrawBindStats>(threads, "worker bind stats");
+    auto job = [&](uint32_t worker) {
+        TRACE_ZONE("recordWorker");
+        vkResetCommandPool(vkDevice->getDevice(), frame.secondaryPools[worker], 0);
+        VkCommandBuffer secondary = frame.secondaryCommandBuffers[worker];
+        vkBeginCommandBuffer(secondary, &secondaryBegin);
+        setViewportAndScissor(secondary); // dynamic state isn't inherited from the primary
+        workerStats[worker] = DrawBindStats{};
+        recordObjectRange(secondary, frame, packets, objectCount * worker / threads, objectCount * (worker + 1) / threads, mvps, false,
+                          workerStats[worker]);
+        vkEndCommandBuffer(secondary);
+    };
+    workerPool->run(threads, job);
+    drawBindStats = DrawBindStats{};
+    for (uint32_t worker = 0; worker < threads; ++worker) {
+        drawBindStats.draws += workerStats[worker].draws;
+        drawBindStats.pipelineBinds += workerStats[worker].pipelineBinds;
+        drawBindStats.vertexBufferBinds += workerStats[worker].vertexBufferBinds;
+        drawBindStats.indexBufferBinds += workerStats[worker].indexBufferBinds;
+    }
+    uint32_t secondaryCount = threads;
+    if (!options.headless) {
+        // ImGui also has to live in a secondary buffer in this subpass
+        vkBeginCommandBuffer(frame.uiCommandBuffer, &secondaryBegin);
+        {
+            GpuScope imguiScope(gpuProfiler, frame.uiCommandBuffer, "imgui");
+            recordImGui(frame.uiCommandBuffer);
+        }
+        vkEndCommandBuffer(frame.uiCommandBuffer);
+        frame.executeList[secondaryCount++] = frame.uiCommandBuffer;
+    }
+    std::copy(frame.secondaryCommandBuffers.begin(), frame.secondaryCommandBuffers.begin() + threads, frame.executeList.begin());
+    vkCmdExecuteCommands(frame.commandBuffer, secondaryCount, frame.executeList.data());
 }
 
 void VulkanApp::initImGui() {
@@ -503,10 +1397,16 @@ void VulkanApp::initImGui() {
     vkCreateDescriptorPool(vkDevice->getDevice(), &pool_info, nullptr, &imguiPool);
 
     IMGUI_CHECKVERSION();
+    // Route ImGui's heap through the allocation counter too
+    ImGui::SetAllocatorFunctions(AllocationCounter::CountedMalloc, AllocationCounter::CountedFree);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImGui::StyleColorsDark();
     ImGui_ImplSDL2_InitForVulkan(window);
+    imguiMemory = &vkDevice->getAllocator();
+    imguiInstance = vkInstance->getInstance();
+    if (!ImGui_ImplVulkan_LoadFunctions(VK_API_VERSION_1_2, LoadImGuiVulkanFunction))
+        throw std::runtime_error("Failed to load Vulkan functions for ImGui");
     ImGui_ImplVulkan_InitInfo init_info = {};
     init_info.Instance = vkInstance->getInstance();
     init_info.PhysicalDevice = vkDevice->getPhysicalDevice();
@@ -517,7 +1417,8 @@ void VulkanApp::initImGui() {
     init_info.DescriptorPool = imguiPool;
     init_info.Allocator = nullptr;
     init_info.MinImageCount = 2;
-    init_info.ImageCount = (uint32_t)swapchain->getImages().size();
+    // ImGui rotates its vertex buffers per rendered frame, so it needs at least one per frame in flight
+    init_info.ImageCount = std::max<uint32_t>((uint32_t)swapchain->getImages().size(), MAX_FRAMES_IN_FLIGHT);
     init_info.CheckVkResultFn = nullptr;
     init_info.RenderPass = renderPass;
     ImGui_ImplVulkan_Init(&init_info);
@@ -539,43 +1440,43 @@ void VulkanApp::recordImGui(VkCommandBuffer cmd) {
 }
 
 void VulkanApp::recreateSwapchain() {
+    TRACE_ZONE("recreateSwapchain");
     int width = 0, height = 0;
     SDL_Vulkan_GetDrawableSize(window, &width, &height);
     while (width == 0 || height == 0) {
         SDL_Vulkan_GetDrawableSize(window, &width, &height);
         SDL_WaitEvent(nullptr);
     }
-    vkDeviceWaitIdle(vkDevice->getDevice());
-    cleanupVulkanResources();
-    SwapchainResources swapRes;
-    swapRes.swapchain = swapchain ? swapchain->getSwapchain() : VK_NULL_HANDLE;
-    swapRes.imageFormat = swapchain ? swapchain->getImageFormat() : VK_FORMAT_UNDEFINED;
-    swapRes.extent = swapchain ? swapchain->getExtent() : VkExtent2D{(uint32_t)width, (uint32_t)height};
-    if (swapchain) delete swapchain;
-    swapchain = new VulkanSwapchain(*vkDevice, vkInstance->getSurface(), window);
-    // Recreate depth resources after swapchain recreation
-    depthResources.format = FindSupportedDepthFormat(vkDevice->getPhysicalDevice());
-    CreateDepthResources(
-        vkDevice->getDevice(),
-        vkDevice->getPhysicalDevice(),
-        swapchain->getExtent(),
-        depthResources.format,
-        depthResources,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
-    );
-    CreateUBODescriptorPool(vkDevice->getDevice(), static_cast<uint32_t>(renderObjects.size()), uboDescriptorPool);
-    CreateSamplerDescriptorPool(vkDevice->getDevice(), static_cast<uint32_t>(renderObjects.size()), samplerDescriptorPool);
-    createDescriptorPool();
-    createDescriptorSet();
-    createRenderPass();
+    // No device wait: frames in flight keep rendering and presenting with the old swapchain,
+    // framebuffers, depth target and present semaphores, which go to the deletion queue and
+    // are destroyed once the newest frame begun so far has retired. The new swapchain is
+    // created with the old one as oldSwapchain, so the driver can hand its resources over.
+    VkDevice device = vkDevice->getDevice();
+    VulkanSwapchain* oldSwapchain = swapchain;
+    swapchain = new VulkanSwapchain(*vkDevice, vkInstance->getSurface(), window, requestedPresentMode, oldSwapchain->getSwapchain());
+    VkFormat oldFormat = oldSwapchain->getImageFormat();
+    std::vector<VkFramebuffer> oldFramebuffers;
+    oldFramebuffers.swap(framebuffers);
+    std::vector<VkSemaphore> oldSemaphores = frameScheduler->detachRenderFinishedSemaphores();
+    deletionQueue->release([device, oldSwapchain, oldFramebuffers, oldSemaphores]() {
+        for (VkFramebuffer fb : oldFramebuffers) vkDestroyFramebuffer(device, fb, nullptr);
+        for (VkSemaphore semaphore : oldSemaphores) vkDestroySemaphore(device, semaphore, nullptr);
+        delete oldSwapchain;
+    });
+    deletionQueue->release(renderTargets->detach());
+    frameScheduler->resizeRenderFinishedSemaphores(swapchain->getImages().size());
+    buildRenderTargets();
+    // Render pass, pipelines (dynamic viewport/scissor), descriptors and ImGui only depend
+    // on the surface format, which practically never changes on resize. When it does they are
+    // rebuilt in place, which does need the frames in flight to be done with them.
+    if (swapchain->getImageFormat() != oldFormat) {
+        vkDeviceWaitIdle(device);
+        shutdownImGui();
+        vkDestroyRenderPass(vkDevice->getDevice(), renderPass, nullptr);
+        createRenderPass();
+        createPipelines();
+        initImGui();
+    }
     createFramebuffers();
-    createCommandPool();
-    createCommandBuffers();
-    if (pipeline) { delete pipeline; pipeline = nullptr; }
-    if (gridPipeline) { delete gridPipeline; gridPipeline = nullptr; }
-    pipeline = new VulkanPipeline(vkDevice->getDevice(), swapchain->getExtent(), renderPass, descriptorSetLayout, VulkanPipeline::Topology::Triangles);
-    gridPipeline = new VulkanPipeline(vkDevice->getDevice(), swapchain->getExtent(), renderPass, descriptorSetLayout, VulkanPipeline::Topology::Lines);
-    shutdownImGui();
-    initImGui();
     framebufferResized = false;
 }
@@ -10,24 +10,50 @@
 #include <memory>
 #include "RenderObject.h"
 #include "CoreRendering.h"
+#include "FrameScheduler.h"
+#include "AppOptions.h"
+#include "Benchmark.h"
+#include "GpuProfiler.h"
+#include "CpuTrace.h"
+#include "FixedTimestep.h"
+#include "WorkerPool.h"
+#include "UploadService.h"
+#include "DeletionQueue.h"
+#include "Defragmenter.h"
+#include "TransformBuffer.h"
+#include "GpuCuller.h"
+#include "DrawList.h"
+#include "AllocationCounter.h"
 // ImGui forward declarations
 struct ImGui_ImplVulkan_InitInfo;
 
 class VulkanApp {
 public:
-    VulkanApp();
+    explicit VulkanApp(const AppOptions& options = AppOptions());
     ~VulkanApp();
     int run();
 private:
+    AppOptions options;
     SDL_Window* window = nullptr;
     VulkanInstance* vkInstance = nullptr;
     VulkanDevice* vkDevice = nullptr;
     VulkanSwapchain* swapchain = nullptr;
     VulkanPipeline* pipeline = nullptr; // For triangles (pyramid)
     VulkanPipeline* gridPipeline = nullptr; // For lines (grid)
+    // --- Draw path: dynamic UBO offset per draw, bindless transforms (one set per command
+    // buffer) or the MVP as a push constant per draw ---
+    DrawPath drawPath = DrawPath::DynamicUBO; // switched from ImGui
+    TransformBuffer* transformBuffer = nullptr;
+    VulkanPipeline* bindlessPipeline = nullptr;
+    VulkanPipeline* bindlessGridPipeline = nullptr;
+    VulkanPipeline* pushPipeline = nullptr;
+    VulkanPipeline* pushGridPipeline = nullptr;
+    // InstancedMeshObject: per-instance vertex stream, MVP pushed; the same for every draw path
+    VulkanPipeline* instancedPipeline = nullptr;
+    VulkanPipeline* getPipeline(const RenderObject& obj) const;
+    void drawDrawPathControls(const FrameContext& frame);
     VulkanBuffer* mvpBuffer = nullptr;
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
-    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
     VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
     VkDescriptorPool uboDescriptorPool = VK_NULL_HANDLE; // Pool for UBOs
     VkDescriptorPool samplerDescriptorPool = VK_NULL_HANDLE; // Pool for samplers
@@ -44,19 +70,77 @@ private:
     bool mouseCaptured = false;
     int lastMouseX = 0, lastMouseY = 0;
 
+    // --- Fixed-timestep simulation (camera movement, scene animation) ---
+    static constexpr double SIMULATION_HZ = 120.0;
+    FixedTimestep simClock{ SIMULATION_HZ };
+    float prevCamX = 0.0f, prevCamY = 1.0f, prevCamZ = 2.5f; // camera position before the last step
+    float renderAlpha = 1.0f;                                 // blend factor used while recording
+    void updateSimulation(double elapsedSeconds);
+    void simulationStep(float dt);
+
     // --- Vulkan resources ---
     VkRenderPass renderPass = VK_NULL_HANDLE;
     std::vector<VkFramebuffer> framebuffers;
-    VkCommandPool commandPool = VK_NULL_HANDLE;
-    std::vector<VkCommandBuffer> commandBuffers;
-    std::vector<VkSemaphore> imageAvailableSemaphores;
-    std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
     static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+    // Per-frame-in-flight command pools, command buffers, uniforms and acquire semaphores
+    FrameContext frames[MAX_FRAMES_IN_FLIGHT];
+    static constexpr size_t FRAME_ARENA_BYTES = 1u << 20; // grows on overflow
+
+    // --- Heap allocations per frame (goal: zero in steady state) ---
+    uint64_t allocationsAtFrameStart = 0;
+    uint64_t frameHeapAllocations = 0; // during the previous frame
+    void sampleHeapAllocations();
+    void drawAllocationOverlay(const FrameContext& frame);
 
     // --- Depth resources (modularized) ---
     DepthResources depthResources;
-    SyncObjects syncObjects;
+    // Owns depth and offscreen color images (transient/lazy memory, aliasing, footprint)
+    RenderTargetAllocator* renderTargets = nullptr;
+    void buildRenderTargets();
+    // Timeline-semaphore frame pacing (replaces per-slot fences)
+    FrameScheduler* frameScheduler = nullptr;
+    // Staging ring for device-local geometry, submitted on the transfer queue; flushed once
+    // per frame before the frame's submit
+    UploadService* uploadService = nullptr;
+    // Highest upload value new geometry depends on; the next frame submit waits for it (once)
+    uint64_t requiredUploadValue = 0;
+    void submitUploads();
+    // Buffers released mid-session wait here for their last frame, then get recycled
+    DeletionQueue* deletionQueue = nullptr;
+    // Moves geometry out of sparse memory blocks, a few KiB per frame
+    Defragmenter* defragmenter = nullptr;
+    int defragBudgetKiB = 0; // per frame, switched from ImGui
+
+    // --- Headless rendering (no window/surface/swapchain) ---
+    OffscreenTarget offscreenTarget;
+    std::vector<uint64_t> pendingReadbacks; // per offscreen image: frame number awaiting write-out (0 = none)
+    std::vector<unsigned char> readbackStaging;
+    // Render target queries that work for both the swapchain and the offscreen target
+    VkExtent2D getRenderExtent() const;
+    VkFormat getColorFormat() const;
+    const std::vector<VkImageView>& getColorImageViews() const;
+    void headlessLoop();
+    void writePendingReadback(uint32_t imageIndex);
+
+    // --- Benchmark (--bench) + GPU frame time ---
+    Benchmark* benchmark = nullptr;
+    // GPU timestamp scopes (render pass, each draw, ImGui); results lag a few frames
+    GpuProfiler* gpuProfiler = nullptr;
+    void collectGpuTimings(FrameContext& frame, uint32_t slot);
+    void drawGpuProfilerTree();
+    void drawMemoryOverlay();
+    void dumpCpuTrace();
+    void applyBenchmarkCamera();
+    void endBenchmarkFrame(FrameContext& frame, double frameMs);
+    // Writes the report; with --bench-threads / --bench-draw-paths it starts the next run and
+    // returns false until the sweep is done
+    bool finishBenchmark();
+    size_t benchmarkSweepRuns() const;
+    void applyBenchmarkSweepRun(size_t run);
+    // Falls back to DynamicUBO (with a warning) when Bindless is asked for without descriptor indexing
+    DrawPath supportedDrawPath(DrawPath requested) const;
+    bool benchmarkDone = false;
+    std::vector<std::string> sweepReports;
 
     // --- ImGui integration ---
     VkDescriptorPool imguiPool = VK_NULL_HANDLE;
@@ -72,21 +156,80 @@ private:
 
     // Modular render objects
     std::vector<std::unique_ptr<RenderObject>> renderObjects;
+    // Runtime scene edits (no device idle: buffers go through deletionQueue)
+    void addPyramid();
+    void removePyramid();
+    void removeObject(size_t index);
+    void drawSceneControls();
+    // --- Instanced scene (--instanced or an instanced-* scenario): every pyramid is an
+    // instance of one InstancedMeshObject ---
+    InstancedMeshObject* instancedPyramids = nullptr; // owned by renderObjects; null if not instanced
+    std::vector<uint32_t> pyramidInstances;           // instance handles, in creation order
+    // The spin animation updates this many instances per step, so a million-instance scene
+    // still only uploads a few KiB a frame
+    static constexpr uint32_t ANIMATED_INSTANCES = 256;
+    float instanceSpin = 0.0f;
+    // GPU-driven culling (needs VulkanDevice::hasGpuDrivenDraws()); the indirect fields of
+    // cullDraws are what this frame's instanced draw reads. Plain objects are culled too on
+    // the bindless path when the device has drawIndirectCount (cullsObjects()).
+    GpuCuller* gpuCuller = nullptr;
+    bool gpuCulling = false;
+    DrawBinding cullDraws;
+    uint64_t sceneVersion = 0; // bumped when objects are added or removed (GpuCuller rebuilds its batches)
+    bool cullsObjects() const;
+    void recordObjectBatches(VkCommandBuffer cmd, FrameContext& frame, DrawBindStats& stats);
 
     void mainLoop();
+    uint64_t renderedFrames = 0;
     void handleEvents(bool& running);
     void createDescriptorSetLayout();
-    void createDescriptorPool();
     void createDescriptorSet();
+    void writeFrameDescriptor(FrameContext& frame);
+    void resizeUniformRing(FrameContext& frame);
+    VkDeviceSize uniformRingBytes() const;
     void updateMVPBuffer();
     void createBuffers();
     void createRenderPass();
     void createFramebuffers();
-    void createCommandPool();
-    void createCommandBuffers();
+    void createFrameContexts();
     void createSyncObjects();
-    void recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex);
+    void recordCommandBuffer(FrameContext& frame, uint32_t slot, uint32_t imageIndex);
+    Mat4 computeViewProj() const;
+    void setViewportAndScissor(VkCommandBuffer cmd) const;
+    // --- Draw list: packets sorted by pipeline, mesh, material, depth (DrawList.h) ---
+    bool sortDraws = true;         // switched from ImGui
+    DrawBindStats drawBindStats;   // last recorded frame
+    // objects: the renderObjects indices to draw (null = all of them)
+    DrawPacket* buildDrawList(FrameContext& frame, const Mat4* mvps, const uint32_t* objects, uint32_t count);
+    // Draws packets [begin, end); binds only what differs from the previous packet's draw
+    void recordObjectRange(VkCommandBuffer cmd, FrameContext& frame, const DrawPacket* packets, size_t begin, size_t end,
+                           const Mat4* mvps, bool profileDraws, DrawBindStats& stats);
+
+    // --- Multithreaded recording (secondary command buffers, one pool per thread) ---
+    static constexpr uint32_t MAX_RECORD_THREADS = 16;
+    WorkerPool* workerPool = nullptr;
+    int recordThreads = 0; // 0 = record inline on the main thread; switched from ImGui
+    double recordMs = 0.0; // CPU time of the last recordCommandBuffer call
+    void recordObjectsParallel(FrameContext& frame, uint32_t imageIndex, const DrawPacket* packets, uint32_t packetCount, const Mat4* mvps,
+                               uint32_t threads);
     void cleanupVulkanResources();
     void recreateSwapchain();
+    void destroySwapchainResources();
+
+    // --- Present policy, frame limiter, input latency ---
+    VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR; // switched from ImGui
+    int fpsLimit = 0;                                                    // 0 = unlimited
+    std::chrono::steady_clock::time_point nextFrameStart{};
+    void limitFrameRate();
+    // Oldest input event not yet reflected in a presented frame (SDL event timestamp)
+    bool inputPending = false;
+    std::chrono::steady_clock::time_point pendingInputTime;
+    double inputLatencyMs = 0.0, inputLatencyAvgMs = 0.0, inputLatencyMaxMs = 0.0;
+    double latencyAccumMs = 0.0, latencyWindowMaxMs = 0.0;
+    int latencySamples = 0;
+    std::chrono::steady_clock::time_point latencyWindowStart;
+    void notePresentForLatency();
+    void drawPresentControls();
+    void createPipelines();
     bool framebufferResized = false;
 };
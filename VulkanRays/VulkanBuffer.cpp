@@ -1,26 +1,40 @@
 #include "VulkanBuffer.h"
 #include <stdexcept>
 #include <cstring>
+#include "CpuTrace.h"
 
-VulkanBuffer::VulkanBuffer(VulkanDevice& device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
-    : device(device.getDevice()) {
+VulkanBuffer::VulkanBuffer(VulkanDevice& device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MemoryCategory category, bool shareAcrossQueues)
+    : device(device.getDevice()), allocator(&device.getAllocator()), size(size), usage(usage), properties(properties),
+      category(category), shareAcrossQueues(shareAcrossQueues) {
+    buffer = createHandle(device, size, usage, shareAcrossQueues);
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device.getDevice(), buffer, &memRequirements);
+    allocation = allocator->allocate(memRequirements, properties, AllocationKind::Linear, category);
+    vkBindBufferMemory(device.getDevice(), buffer, allocation.memory, allocation.offset);
+    if (isMovable()) allocator->setOwner(allocation, this);
+}
+
+VkBuffer VulkanBuffer::createHandle(VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, bool shareAcrossQueues) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    if (vkCreateBuffer(device.getDevice(), &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    const auto& families = device.getQueueFamilies();
+    if (shareAcrossQueues && families.size() > 1) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+        bufferInfo.pQueueFamilyIndices = families.data();
+    }
+    VkBuffer handle = VK_NULL_HANDLE;
+    if (vkCreateBuffer(device.getDevice(), &bufferInfo, nullptr, &handle) != VK_SUCCESS)
         throw std::runtime_error("Failed to create buffer");
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device.getDevice(), buffer, &memRequirements);
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    // Find memory type index (user must provide helper in VulkanDevice)
-    allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, properties); // Set correct memory type index
-    if (vkAllocateMemory(device.getDevice(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
-        throw std::runtime_error("Failed to allocate buffer memory");
-    vkBindBufferMemory(device.getDevice(), buffer, memory, 0);
+    return handle;
+}
+
+bool VulkanBuffer::isMovable() const {
+    const VkBufferUsageFlags copyBits = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    return (usage & copyBits) == copyBits && !(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 }
 
 VulkanBuffer::~VulkanBuffer() {
@@ -32,15 +46,23 @@ void VulkanBuffer::destroy() {
         vkDestroyBuffer(device, buffer, nullptr);
         buffer = VK_NULL_HANDLE;
     }
-    if (memory) {
-        vkFreeMemory(device, memory, nullptr);
-        memory = VK_NULL_HANDLE;
-    }
+    allocator->free(allocation);
+}
+
+void VulkanBuffer::write(VkDeviceSize offset, const void* src, VkDeviceSize size) {
+    TRACE_ZONE("VulkanBuffer::write");
+    // Host-visible blocks stay mapped, so this is a plain copy
+    if (!allocation.mapped) throw std::runtime_error("Failed to write buffer data: memory is not host-visible");
+    std::memcpy(static_cast<char*>(allocation.mapped) + offset, src, (size_t)size);
+    allocator->flushRange(allocation, offset, size);
+}
+
+void VulkanBuffer::markWritten(VkDeviceSize offset, VkDeviceSize size) {
+    allocator->flushRange(allocation, offset, size);
 }
 
-void VulkanBuffer::uploadData(const void* src, VkDeviceSize size) {
-    void* data;
-    vkMapMemory(device, memory, 0, size, 0, &data);
-    std::memcpy(data, src, (size_t)size);
-    vkUnmapMemory(device, memory);
+void VulkanBuffer::downloadData(void* dst, VkDeviceSize size) {
+    if (!allocation.mapped) throw std::runtime_error("Failed to read buffer data: memory is not host-visible");
+    allocator->invalidateRange(allocation, 0, size);
+    std::memcpy(dst, allocation.mapped, (size_t)size);
 }
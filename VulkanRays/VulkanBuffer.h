@@ -4,14 +4,44 @@
 
 class VulkanBuffer {
 public:
-    VulkanBuffer(VulkanDevice& device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+    // Memory comes from the device's MemoryAllocator (a range of a shared block). Host-visible
+    // buffers are persistently mapped; writes to non-coherent memory are queued and flushed
+    // for all buffers at once by MemoryAllocator::flushPending (once per frame).
+    // category: what the memory is reported under (MemoryStats::categories).
+    // shareAcrossQueues: VK_SHARING_MODE_CONCURRENT over all device queue families, for
+    // buffers written on the transfer queue and read on the graphics queue (no ownership transfer)
+    VulkanBuffer(VulkanDevice& device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                 MemoryCategory category = MemoryCategory::Other, bool shareAcrossQueues = false);
     ~VulkanBuffer();
     VkBuffer getBuffer() const { return buffer; }
-    VkDeviceMemory getMemory() const { return memory; }
-    void uploadData(const void* src, VkDeviceSize size);
+    VkDeviceMemory getMemory() const { return allocation.memory; }
+    VkDeviceSize getMemoryOffset() const { return allocation.offset; }
+    // Creation parameters, so a retired buffer can be matched for reuse (DeletionQueue)
+    VkDeviceSize getSize() const { return size; }
+    VkBufferUsageFlags getUsage() const { return usage; }
+    VkMemoryPropertyFlags getMemoryProperties() const { return properties; }
+    MemoryCategory getCategory() const { return category; }
+    bool isSharedAcrossQueues() const { return shareAcrossQueues; }
+    void uploadData(const void* src, VkDeviceSize size) { write(0, src, size); }
+    void write(VkDeviceSize offset, const void* src, VkDeviceSize size);
+    // For writing in place (e.g. from several recording threads): mark the range once done
+    void* getMappedData() const { return allocation.mapped; }
+    void markWritten(VkDeviceSize offset, VkDeviceSize size);
+    void downloadData(void* dst, VkDeviceSize size); // host-visible buffers only
     void destroy(); // Explicit destroy for manual cleanup
+    // Device-local buffers with TRANSFER_SRC and TRANSFER_DST usage can be relocated by the
+    // Defragmenter; getBuffer() changes when that happens, so don't cache the handle across frames
+    bool isMovable() const;
 private:
+    friend class Defragmenter;
+    static VkBuffer createHandle(VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, bool shareAcrossQueues);
     VkDevice device;
+    MemoryAllocator* allocator;
     VkBuffer buffer = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    MemoryAllocation allocation;
+    VkDeviceSize size;
+    VkBufferUsageFlags usage;
+    VkMemoryPropertyFlags properties;
+    MemoryCategory category;
+    bool shareAcrossQueues;
 };
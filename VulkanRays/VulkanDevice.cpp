@@ -2,8 +2,19 @@
 #include <vector>
 #include <set>
 #include <stdexcept>
+#include <cstring>
 
 namespace {
+bool supportsTimelineSemaphores(VkPhysicalDevice dev) {
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(dev, &features);
+    return features12.timelineSemaphore == VK_TRUE;
+}
+
 bool isDeviceSuitable(VkPhysicalDevice dev, VkSurfaceKHR surface, uint32_t& graphicsIdx, uint32_t& presentIdx) {
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(dev, &queueFamilyCount, nullptr);
@@ -15,15 +26,51 @@ bool isDeviceSuitable(VkPhysicalDevice dev, VkSurfaceKHR surface, uint32_t& grap
             graphicsIdx = i;
             foundGraphics = true;
         }
+        // Surface-less (headless) devices never present; the graphics queue stands in
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupport);
+        if (surface)
+            vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupport);
+        else
+            presentSupport = (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
         if (presentSupport) {
             presentIdx = i;
             foundPresent = true;
         }
         if (foundGraphics && foundPresent) break;
     }
-    return foundGraphics && foundPresent;
+    // Frame pacing (FrameScheduler) is built on Vulkan 1.2 timeline semaphores
+    return foundGraphics && foundPresent && supportsTimelineSemaphores(dev);
+}
+
+bool supportsExtension(VkPhysicalDevice dev, const char* name) {
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(dev, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> extensions(count);
+    vkEnumerateDeviceExtensionProperties(dev, nullptr, &count, extensions.data());
+    for (const auto& ext : extensions)
+        if (std::strcmp(ext.extensionName, name) == 0) return true;
+    return false;
+}
+
+// Family with `required` but none of `excluded`, preferring the fewest other capabilities
+// (a transfer-only family is the DMA engine on most discrete GPUs). UINT32_MAX if none.
+uint32_t findDedicatedFamily(VkPhysicalDevice dev, VkQueueFlags required, VkQueueFlags excluded) {
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(dev, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(dev, &count, families.data());
+    uint32_t best = UINT32_MAX, bestExtra = UINT32_MAX;
+    for (uint32_t i = 0; i < count; ++i) {
+        VkQueueFlags flags = families[i].queueFlags;
+        if ((flags & required) != required || (flags & excluded) || families[i].queueCount == 0) continue;
+        uint32_t extra = 0;
+        for (VkQueueFlags rest = flags & ~required; rest; rest &= rest - 1) ++extra;
+        if (extra < bestExtra) {
+            best = i;
+            bestExtra = extra;
+        }
+    }
+    return best;
 }
 }
 
@@ -44,8 +91,16 @@ VulkanDevice::VulkanDevice(VkInstance instance, VkSurfaceKHR surface) {
         }
     }
     if (physicalDevice == VK_NULL_HANDLE) throw std::runtime_error("No suitable Vulkan device found");
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    // Optional extra queues; without them transfer/compute work shares the graphics queue
+    transferQueueFamily = findDedicatedFamily(physicalDevice, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (transferQueueFamily == UINT32_MAX)
+        transferQueueFamily = findDedicatedFamily(physicalDevice, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT);
+    if (transferQueueFamily == UINT32_MAX) transferQueueFamily = graphicsQueueFamily;
+    computeQueueFamily = findDedicatedFamily(physicalDevice, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+    if (computeQueueFamily == UINT32_MAX) computeQueueFamily = graphicsQueueFamily;
     // Create logical device
-    std::set<uint32_t> uniqueFamilies = { graphicsQueueFamily, presentQueueFamily };
+    std::set<uint32_t> uniqueFamilies = { graphicsQueueFamily, presentQueueFamily, transferQueueFamily, computeQueueFamily };
     float queuePriority = 1.0f;
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     for (uint32_t family : uniqueFamilies) {
@@ -56,11 +111,48 @@ VulkanDevice::VulkanDevice(VkInstance instance, VkSurfaceKHR surface) {
         queueInfo.pQueuePriorities = &queuePriority;
         queueCreateInfos.push_back(queueInfo);
     }
-    const std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    std::vector<const char*> deviceExtensions;
+    if (surface) deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    // Optional: real per-heap budget/usage (including other processes) for the memory overlay
+    memoryBudgetSupported = supportsExtension(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudgetSupported) deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    // Optional: GPU culling dispatches on the graphics queue. Instances are drawn with one
+    // plain vkCmdDrawIndexedIndirect; plain objects need vkCmdDrawIndexedIndirectCount, several
+    // commands per call and a firstInstance per command (see hasIndirectCount)
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> familyProperties(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, familyProperties.data());
+    gpuDrivenSupported = (familyProperties[graphicsQueueFamily].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+    // Optional: bindless transforms (TransformBuffer) index a runtime array of storage buffers
+    // with a push constant and rewrite one element while frames using the others are in flight
+    VkPhysicalDeviceVulkan12Features supported12{};
+    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 supported{};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &supported12;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+    descriptorIndexingSupported = supported.features.shaderStorageBufferArrayDynamicIndexing &&
+                                  supported12.runtimeDescriptorArray &&
+                                  supported12.descriptorBindingPartiallyBound &&
+                                  supported12.descriptorBindingUpdateUnusedWhilePending;
+    indirectCountSupported = supported12.drawIndirectCount && supported.features.multiDrawIndirect &&
+                             supported.features.drawIndirectFirstInstance;
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    enabledFeatures.shaderStorageBufferArrayDynamicIndexing = descriptorIndexingSupported;
+    enabledFeatures.multiDrawIndirect = indirectCountSupported;
+    enabledFeatures.drawIndirectFirstInstance = indirectCountSupported;
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.timelineSemaphore = VK_TRUE;
+    features12.runtimeDescriptorArray = descriptorIndexingSupported;
+    features12.descriptorBindingPartiallyBound = descriptorIndexingSupported;
+    features12.descriptorBindingUpdateUnusedWhilePending = descriptorIndexingSupported;
+    features12.drawIndirectCount = indirectCountSupported;
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &features12;
+    createInfo.pEnabledFeatures = &enabledFeatures;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
@@ -69,9 +161,14 @@ VulkanDevice::VulkanDevice(VkInstance instance, VkSurfaceKHR surface) {
         throw std::runtime_error("Failed to create logical device");
     vkGetDeviceQueue(device, graphicsQueueFamily, 0, &graphicsQueue);
     vkGetDeviceQueue(device, presentQueueFamily, 0, &presentQueue);
+    vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+    vkGetDeviceQueue(device, computeQueueFamily, 0, &computeQueue);
+    queueFamilies.assign(uniqueFamilies.begin(), uniqueFamilies.end());
+    allocator = new MemoryAllocator(device, physicalDevice);
 }
 
 VulkanDevice::~VulkanDevice() {
+    delete allocator; // frees the memory blocks, so it has to go before the device
     if (device) {
         vkDestroyDevice(device, nullptr);
     }
@@ -93,3 +190,21 @@ uint32_t VulkanDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags
     }
     throw std::runtime_error("Failed to find suitable memory type");
 }
+
+uint32_t VulkanDevice::getMemoryBudget(MemoryHeapBudget (&heaps)[VK_MAX_MEMORY_HEAPS]) const {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 props{};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    props.pNext = memoryBudgetSupported ? &budget : nullptr;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &props);
+    const VkPhysicalDeviceMemoryProperties& memory = props.memoryProperties;
+    for (uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+        heaps[i].size = memory.memoryHeaps[i].size;
+        heaps[i].deviceLocal = (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        // Without the extension the whole heap is the budget and usage is unknown
+        heaps[i].budget = memoryBudgetSupported ? budget.heapBudget[i] : memory.memoryHeaps[i].size;
+        heaps[i].usage = memoryBudgetSupported ? budget.heapUsage[i] : 0;
+    }
+    return memory.memoryHeapCount;
+}
@@ -1,8 +1,18 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <vector>
+#include "MemoryAllocator.h"
+
+struct MemoryHeapBudget {
+    VkDeviceSize size = 0;
+    VkDeviceSize budget = 0;  // how much this process can use before the driver starts evicting/failing
+    VkDeviceSize usage = 0;   // this process's usage as the driver sees it
+    bool deviceLocal = false;
+};
 
 class VulkanDevice {
 public:
+    // surface may be VK_NULL_HANDLE (headless): no swapchain extension, present queue == graphics queue
     VulkanDevice(VkInstance instance, VkSurfaceKHR surface);
     ~VulkanDevice();
     VkDevice getDevice() const;
@@ -11,8 +21,32 @@ public:
     VkQueue getPresentQueue() const;
     uint32_t getGraphicsQueueFamily() const;
     uint32_t getPresentQueueFamily() const;
+    // Dedicated transfer / async compute queues; both fall back to the graphics queue (same
+    // VkQueue, same family) when the device has no suitable separate family
+    VkQueue getTransferQueue() const { return transferQueue; }
+    uint32_t getTransferQueueFamily() const { return transferQueueFamily; }
+    bool hasDedicatedTransferQueue() const { return transferQueueFamily != graphicsQueueFamily; }
+    VkQueue getComputeQueue() const { return computeQueue; }
+    uint32_t getComputeQueueFamily() const { return computeQueueFamily; }
+    bool hasAsyncComputeQueue() const { return computeQueueFamily != graphicsQueueFamily; }
+    // Every family a queue was created for (for VK_SHARING_MODE_CONCURRENT resources)
+    const std::vector<uint32_t>& getQueueFamilies() const { return queueFamilies; }
+    const VkPhysicalDeviceProperties& getProperties() const { return properties; }
     // Utility for memory type selection
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    // Sub-allocator for buffer/image memory; lives as long as the logical device
+    MemoryAllocator& getAllocator() { return *allocator; }
+    // VK_EXT_memory_budget: budget/usage per heap. Fills heaps and returns the heap count;
+    // without the extension budget = heap size and usage = 0.
+    bool hasMemoryBudget() const { return memoryBudgetSupported; }
+    uint32_t getMemoryBudget(MemoryHeapBudget (&heaps)[VK_MAX_MEMORY_HEAPS]) const;
+    // GPU-driven draws (see GpuCuller): compute on the graphics queue
+    bool hasGpuDrivenDraws() const { return gpuDrivenSupported; }
+    // ... and for culling plain objects: vkCmdDrawIndexedIndirectCount with many draws, each
+    // with its own firstInstance
+    bool hasIndirectCount() const { return indirectCountSupported; }
+    // Descriptor indexing features the bindless draw path needs (see TransformBuffer)
+    bool hasDescriptorIndexing() const { return descriptorIndexingSupported; }
 private:
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice device = VK_NULL_HANDLE;
@@ -20,5 +54,16 @@ private:
     VkQueue presentQueue = VK_NULL_HANDLE;
     uint32_t graphicsQueueFamily = 0;
     uint32_t presentQueueFamily = 0;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    uint32_t transferQueueFamily = 0;
+    uint32_t computeQueueFamily = 0;
+    std::vector<uint32_t> queueFamilies;
+    bool memoryBudgetSupported = false;
+    bool gpuDrivenSupported = false;
+    bool descriptorIndexingSupported = false;
+    bool indirectCountSupported = false;
+    VkPhysicalDeviceProperties properties{};
+    MemoryAllocator* allocator = nullptr;
     // ...other members...
 };
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <SDL_vulkan.h>
 #include <cstring>
+#include <stdexcept>
 
 namespace {
 const std::vector<const char*> validationLayers = {
@@ -71,12 +72,16 @@ VulkanInstance::VulkanInstance(SDL_Window* window, bool enableValidation) {
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
-    unsigned int extCount = 0;
-    if (!SDL_Vulkan_GetInstanceExtensions(window, &extCount, nullptr)) {
-        throw std::runtime_error("Failed to get SDL Vulkan extensions count");
+    // Headless (no window): no surface, so no WSI instance extensions either
+    std::vector<const char*> extensions;
+    if (window) {
+        unsigned int extCount = 0;
+        if (!SDL_Vulkan_GetInstanceExtensions(window, &extCount, nullptr)) {
+            throw std::runtime_error("Failed to get SDL Vulkan extensions count");
+        }
+        extensions.resize(extCount);
+        SDL_Vulkan_GetInstanceExtensions(window, &extCount, extensions.data());
     }
-    std::vector<const char*> extensions(extCount);
-    SDL_Vulkan_GetInstanceExtensions(window, &extCount, extensions.data());
     if (enableValidation) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -89,7 +94,7 @@ VulkanInstance::VulkanInstance(SDL_Window* window, bool enableValidation) {
     if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create Vulkan instance");
     }
-    if (!SDL_Vulkan_CreateSurface(window, instance, &surface)) {
+    if (window && !SDL_Vulkan_CreateSurface(window, instance, &surface)) {
         throw std::runtime_error("SDL_Vulkan_CreateSurface failed");
     }
     if (enableValidation) {
@@ -4,6 +4,7 @@
 
 class VulkanInstance {
 public:
+    // window may be null for headless rendering; getSurface() is then VK_NULL_HANDLE
     VulkanInstance(SDL_Window* window, bool enableValidation);
     ~VulkanInstance();
     VkInstance getInstance() const;
@@ -1,9 +1,13 @@
 #include "VulkanPipeline.h"
 #include <stdexcept>
 #include <vector>
+#include <cstring>
 #include <cstddef> // for offsetof
 #include "shaders/triangle.vert.inc"
 #include "shaders/triangle.frag.inc"
+#include "shaders/triangle_bindless.vert.inc"
+#include "shaders/triangle_push.vert.inc"
+#include "shaders/instanced.vert.inc"
 
 // Vertex structure matching the shader
 struct Vertex {
@@ -11,15 +15,46 @@ struct Vertex {
     float color[3];
 };
 
-VulkanPipeline::VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, Topology topology)
+namespace {
+const struct { DrawPath path; const char* name; } kDrawPathNames[] = {
+    { DrawPath::DynamicUBO, "ubo" },
+    { DrawPath::Bindless, "bindless" },
+    { DrawPath::PushConstants, "push" },
+};
+}
+
+const char* DrawPathName(DrawPath path) {
+    for (const auto& entry : kDrawPathNames)
+        if (entry.path == path) return entry.name;
+    return "unknown";
+}
+
+bool ParseDrawPath(const char* name, DrawPath& out) {
+    for (const auto& entry : kDrawPathNames) {
+        if (std::strcmp(entry.name, name) == 0) {
+            out = entry.path;
+            return true;
+        }
+    }
+    return false;
+}
+
+VulkanPipeline::VulkanPipeline(VkDevice device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, Topology topology,
+                               DrawPath drawPath, VertexInput vertexInput)
     : device(device) {
+    bool instanced = vertexInput == VertexInput::Instanced;
+    if (instanced) drawPath = DrawPath::PushConstants;
     // Vertex input binding and attribute descriptions
-    VkVertexInputBindingDescription bindingDescription{};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    VkVertexInputAttributeDescription attributeDescriptions[2] = {};
+    VkVertexInputBindingDescription bindingDescriptions[2] = {};
+    bindingDescriptions[0].binding = 0;
+    bindingDescriptions[0].stride = sizeof(Vertex);
+    bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    // InstanceData: three vec4 model rows and a vec4 tint, advanced once per instance
+    bindingDescriptions[1].binding = 1;
+    bindingDescriptions[1].stride = sizeof(float) * 16;
+    bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription attributeDescriptions[6] = {};
     attributeDescriptions[0].location = 0;
     attributeDescriptions[0].binding = 0;
     attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
@@ -28,12 +63,18 @@ VulkanPipeline::VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass
     attributeDescriptions[1].binding = 0;
     attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
     attributeDescriptions[1].offset = offsetof(Vertex, color);
+    for (uint32_t i = 0; i < 4; ++i) {
+        attributeDescriptions[2 + i].location = 2 + i;
+        attributeDescriptions[2 + i].binding = 1;
+        attributeDescriptions[2 + i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescriptions[2 + i].offset = sizeof(float) * 4 * i;
+    }
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.vertexAttributeDescriptionCount = 2;
+    vertexInputInfo.vertexBindingDescriptionCount = instanced ? 2 : 1;
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions;
+    vertexInputInfo.vertexAttributeDescriptionCount = instanced ? 6 : 2;
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
 
     // Input assembly
@@ -42,23 +83,16 @@ VulkanPipeline::VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass
     inputAssembly.topology = (topology == Topology::Triangles) ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    // Viewport and scissor
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)extent.width;
-    viewport.height = (float)extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = extent;
+    // Viewport and scissor (dynamic, set in recordCommandBuffer)
     VkPipelineViewportStateCreateInfo viewportState{};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
 
     // Rasterizer
     VkPipelineRasterizationStateCreateInfo rasterizer{};
@@ -99,8 +133,18 @@ VulkanPipeline::VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass
     // Pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.setLayoutCount = descriptorSetLayout ? 1 : 0;
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayout ? &descriptorSetLayout : nullptr;
+    // Push constants: the whole MVP (64 bytes, well inside the 128 bytes every device
+    // guarantees), or for Bindless just the frame slot that picks the transform buffer
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = drawPath == DrawPath::Bindless ? sizeof(uint32_t) : sizeof(float) * 16;
+    if (drawPath != DrawPath::DynamicUBO) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create pipeline layout");
 
@@ -110,6 +154,16 @@ VulkanPipeline::VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass
     vertCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     vertCreateInfo.codeSize = triangle_vert_spv_len;
     vertCreateInfo.pCode = reinterpret_cast<const uint32_t*>(triangle_vert_spv);
+    if (drawPath == DrawPath::Bindless) {
+        vertCreateInfo.codeSize = triangle_bindless_vert_spv_len;
+        vertCreateInfo.pCode = reinterpret_cast<const uint32_t*>(triangle_bindless_vert_spv);
+    } else if (instanced) {
+        vertCreateInfo.codeSize = instanced_vert_spv_len;
+        vertCreateInfo.pCode = reinterpret_cast<const uint32_t*>(instanced_vert_spv);
+    } else if (drawPath == DrawPath::PushConstants) {
+        vertCreateInfo.codeSize = triangle_push_vert_spv_len;
+        vertCreateInfo.pCode = reinterpret_cast<const uint32_t*>(triangle_push_vert_spv);
+    }
     if (vkCreateShaderModule(device, &vertCreateInfo, nullptr, &vertShaderModule) != VK_SUCCESS)
         throw std::runtime_error("Failed to create vertex shader module");
 
@@ -143,6 +197,7 @@ VulkanPipeline::VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass
     pipelineInfo.pMultisampleState = &multisampling;
     pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = pipelineLayout;
     pipelineInfo.renderPass = renderPass;
     pipelineInfo.subpass = 0;
@@ -1,13 +1,32 @@
 #pragma once
 #include <vulkan/vulkan.h>
 
+// How the vertex shader gets each object's MVP
+enum class DrawPath {
+    DynamicUBO, // triangle.vert: frame's uniform ring through a dynamic UBO, bound per draw
+    Bindless,   // triangle_bindless.vert: frame's transform SSBO (TransformBuffer), bound once, firstInstance = object
+    PushConstants // triangle_push.vert: 64-byte push constant per draw, no descriptor set at all
+};
+const char* DrawPathName(DrawPath path);
+bool ParseDrawPath(const char* name, DrawPath& out);
+
 class VulkanPipeline {
 public:
     enum class Topology {
         Triangles,
         Lines
     };
-    VulkanPipeline(VkDevice device, VkExtent2D extent, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, Topology topology = Topology::Triangles);
+    // Instanced: binding 1 is a per-instance stream of InstanceData (see InstancedMeshObject),
+    // and the MVP is always a push constant
+    enum class VertexInput {
+        PerVertex,
+        Instanced
+    };
+    // Viewport and scissor are dynamic state, so pipelines survive swapchain resizes
+    // descriptorSetLayout: set 0 of the draw path (dynamic UBO, or TransformBuffer::getSetLayout());
+    // VK_NULL_HANDLE for DrawPath::PushConstants and VertexInput::Instanced
+    VulkanPipeline(VkDevice device, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout, Topology topology = Topology::Triangles,
+                   DrawPath drawPath = DrawPath::DynamicUBO, VertexInput vertexInput = VertexInput::PerVertex);
     ~VulkanPipeline();
     VkPipeline getGraphicsPipeline() const { return graphicsPipeline; }
     VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
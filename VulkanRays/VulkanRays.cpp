@@ -1,7 +1,10 @@
 ﻿#include "VulkanRays.h"
 #include "VulkanApp.h"
+#include "AppOptions.h"
 
 int main(int argc, char** argv) {
-    VulkanApp app;
+    AppOptions options;
+    if (!ParseAppOptions(argc, argv, options)) return 1;
+    VulkanApp app(options);
     return app.run();
 }
\ No newline at end of file
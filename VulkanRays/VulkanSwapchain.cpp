@@ -1,11 +1,13 @@
 #include "VulkanSwapchain.h"
 #include <algorithm>
 #include <stdexcept>
+#include <cstring>
 #include <SDL_vulkan.h>
 
-VulkanSwapchain::VulkanSwapchain(VulkanDevice& device, VkSurfaceKHR surface, SDL_Window* window)
+VulkanSwapchain::VulkanSwapchain(VulkanDevice& device, VkSurfaceKHR surface, SDL_Window* window,
+                                 VkPresentModeKHR preferredPresentMode, VkSwapchainKHR oldSwapchain)
     : device(device) {
-    createSwapchain(surface, window);
+    createSwapchain(surface, window, preferredPresentMode, oldSwapchain);
     createImageViews();
 }
 
@@ -18,7 +20,7 @@ VulkanSwapchain::~VulkanSwapchain() {
     }
 }
 
-void VulkanSwapchain::createSwapchain(VkSurfaceKHR surface, SDL_Window* window) {
+void VulkanSwapchain::createSwapchain(VkSurfaceKHR surface, SDL_Window* window, VkPresentModeKHR preferredPresentMode, VkSwapchainKHR oldSwapchain) {
     VkSurfaceCapabilitiesKHR caps;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.getPhysicalDevice(), surface, &caps);
     uint32_t formatCount;
@@ -34,11 +36,11 @@ void VulkanSwapchain::createSwapchain(VkSurfaceKHR surface, SDL_Window* window)
     }
     uint32_t presentModeCount;
     vkGetPhysicalDeviceSurfacePresentModesKHR(device.getPhysicalDevice(), surface, &presentModeCount, nullptr);
-    std::vector<VkPresentModeKHR> presentModes(presentModeCount);
-    vkGetPhysicalDeviceSurfacePresentModesKHR(device.getPhysicalDevice(), surface, &presentModeCount, presentModes.data());
-    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    for (const auto& pm : presentModes) {
-        if (pm == VK_PRESENT_MODE_MAILBOX_KHR) {
+    supportedPresentModes.resize(presentModeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device.getPhysicalDevice(), surface, &presentModeCount, supportedPresentModes.data());
+    presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    for (const auto& pm : supportedPresentModes) {
+        if (pm == preferredPresentMode) {
             presentMode = pm;
             break;
         }
@@ -72,7 +74,7 @@ void VulkanSwapchain::createSwapchain(VkSurfaceKHR surface, SDL_Window* window)
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = oldSwapchain;
     if (vkCreateSwapchainKHR(device.getDevice(), &createInfo, nullptr, &swapchain) != VK_SUCCESS)
         throw std::runtime_error("Failed to create swapchain");
     vkGetSwapchainImagesKHR(device.getDevice(), swapchain, &imageCount, nullptr);
@@ -101,3 +103,28 @@ void VulkanSwapchain::createImageViews() {
             throw std::runtime_error("Failed to create image view");
     }
 }
+
+namespace {
+const struct { VkPresentModeKHR mode; const char* name; } kPresentModeNames[] = {
+    { VK_PRESENT_MODE_IMMEDIATE_KHR, "immediate" },
+    { VK_PRESENT_MODE_MAILBOX_KHR, "mailbox" },
+    { VK_PRESENT_MODE_FIFO_KHR, "fifo" },
+    { VK_PRESENT_MODE_FIFO_RELAXED_KHR, "fifo_relaxed" },
+};
+}
+
+const char* PresentModeName(VkPresentModeKHR mode) {
+    for (const auto& entry : kPresentModeNames)
+        if (entry.mode == mode) return entry.name;
+    return "unknown";
+}
+
+bool ParsePresentMode(const char* name, VkPresentModeKHR& out) {
+    for (const auto& entry : kPresentModeNames) {
+        if (std::strcmp(entry.name, name) == 0) {
+            out = entry.mode;
+            return true;
+        }
+    }
+    return false;
+}
@@ -6,11 +6,17 @@
 
 class VulkanSwapchain {
 public:
-    VulkanSwapchain(VulkanDevice& device, VkSurfaceKHR surface, SDL_Window* window);
+    // preferredPresentMode falls back to FIFO (always supported) if the surface lacks it.
+    // oldSwapchain (if any) is retired, not destroyed: the caller deletes the old object afterwards
+    VulkanSwapchain(VulkanDevice& device, VkSurfaceKHR surface, SDL_Window* window,
+                    VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR,
+                    VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
     ~VulkanSwapchain();
     VkSwapchainKHR getSwapchain() const { return swapchain; }
     VkFormat getImageFormat() const { return imageFormat; }
     VkExtent2D getExtent() const { return extent; }
+    VkPresentModeKHR getPresentMode() const { return presentMode; }
+    const std::vector<VkPresentModeKHR>& getSupportedPresentModes() const { return supportedPresentModes; }
     const std::vector<VkImage>& getImages() const { return images; }
     const std::vector<VkImageView>& getImageViews() const { return imageViews; }
 private:
@@ -20,6 +26,12 @@ private:
     std::vector<VkImageView> imageViews;
     VkFormat imageFormat;
     VkExtent2D extent;
-    void createSwapchain(VkSurfaceKHR surface, SDL_Window* window);
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    std::vector<VkPresentModeKHR> supportedPresentModes;
+    void createSwapchain(VkSurfaceKHR surface, SDL_Window* window, VkPresentModeKHR preferredPresentMode, VkSwapchainKHR oldSwapchain);
     void createImageViews();
 };
+
+// "immediate", "mailbox", "fifo", "fifo_relaxed"
+const char* PresentModeName(VkPresentModeKHR mode);
+bool ParsePresentMode(const char* name, VkPresentModeKHR& out);
@@ -0,0 +1,58 @@
+#include "WorkerPool.h"
+#include "CpuTrace.h"
+
+WorkerPool::WorkerPool(uint32_t threadCount) {
+    for (uint32_t i = 0; i < threadCount; ++i)
+        threads.emplace_back(&WorkerPool::workerMain, this, i + 1);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::dispatch(uint32_t count, JobFn fn, void* context) {
+    if (count == 0) return;
+    if (count > getMaxParallelism()) count = getMaxParallelism();
+    if (count > 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobFn = fn;
+        jobContext = context;
+        jobCount = count;
+        pending = count - 1;
+        ++generation;
+    }
+    if (count > 1) workReady.notify_all();
+    fn(context, 0); // the caller takes index 0 instead of idling
+    if (count > 1) {
+        TRACE_ZONE("WorkerPool::join");
+        std::unique_lock<std::mutex> lock(mutex);
+        workDone.wait(lock, [this] { return pending == 0; });
+    }
+}
+
+void WorkerPool::workerMain(uint32_t workerIndex) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        JobFn fn;
+        void* context;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            if (workerIndex >= jobCount) continue; // not needed for this dispatch
+            fn = jobFn;
+            context = jobContext;
+        }
+        fn(context, workerIndex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) workDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- WorkerPool: persistent threads for fork/join work inside a frame ---
+// run(count, job) calls job(i) for i in [0, count): index 0 on the calling thread, the rest
+// on pool threads, and returns once all of them finished. The job is passed by reference
+// and called through a plain function pointer, so dispatching never allocates.
+class WorkerPool {
+public:
+    explicit WorkerPool(uint32_t threadCount);
+    ~WorkerPool();
+
+    // Maximum useful count for run(): pool threads + the calling thread
+    uint32_t getMaxParallelism() const { return static_cast<uint32_t>(threads.size()) + 1; }
+
+    template <typename Job>
+    void run(uint32_t count, Job& job) {
+        dispatch(count, [](void* ctx, uint32_t index) { (*static_cast<Job*>(ctx))(index); }, &job);
+    }
+private:
+    using JobFn = void (*)(void*, uint32_t);
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    JobFn jobFn = nullptr;
+    void* jobContext = nullptr;
+    uint32_t jobCount = 0;       // indices handed out this dispatch
+    uint32_t pending = 0;        // pool-side indices not finished yet
+    uint64_t generation = 0;     // bumped per dispatch to wake the workers
+    bool stopping = false;
+    void dispatch(uint32_t count, JobFn fn, void* context);
+    void workerMain(uint32_t workerIndex);
+};
@@ -1,16 +1,6 @@
 @echo off
 setlocal
 
-REM Set the paths to your shader source files
-set VERT=triangle.vert
-set FRAG=triangle.frag
-
-REM Set the output file names
-set VERT_SPV=triangle.vert.spv
-set FRAG_SPV=triangle.frag.spv
-set VERT_INC=triangle.vert.inc
-set FRAG_INC=triangle.frag.inc
-
 REM Path to glslangValidator
 where glslangValidator >nul 2>nul
 if errorlevel 1 (echo glslangValidator not found. Please ensure it is installed and in your PATH.
@@ -23,34 +13,27 @@ if errorlevel 1 (echo xxd not found. Please ensure it is installed and in your P
 	exit /b 1
 )
 
-REM Compile GLSL to SPIR-V
-echo Compiling %VERT% to %VERT_SPV%...
-glslangValidator -V %VERT% -o %VERT_SPV%
-if errorlevel 1 (
-	echo Failed to compile %VERT%.
-	exit /b 1
+REM Every shader: GLSL -> SPIR-V -> C array (<name>.spv / <name>.inc next to the source)
+for %%S in (triangle.vert triangle.frag triangle_bindless.vert triangle_push.vert instanced.vert cull.comp cull_objects.comp) do (
+	call :compile %%S
+	if errorlevel 1 exit /b 1
 )
 
-echo Compiling %FRAG% to %FRAG_SPV%...
-glslangValidator -V %FRAG% -o %FRAG_SPV%
-if errorlevel 1 (
-	echo Failed to compile %FRAG%.
-	exit /b 1
-)
+echo Shader compilation and conversion completed successfully.
+endlocal
+exit /b 0
 
-REM Convert SPIR-V to C header files
-echo Converting %VERT_SPV% to %VERT_INC%...
-xxd -i %VERT_SPV% > %VERT_INC%
+:compile
+echo Compiling %1 to %1.spv...
+glslangValidator -V %1 -o %1.spv
 if errorlevel 1 (
-	echo Failed to convert %VERT_SPV% to %VERT_INC%.
+	echo Failed to compile %1.
 	exit /b 1
 )
-echo Converting %FRAG_SPV% to %FRAG_INC%...
-xxd -i %FRAG_SPV% > %FRAG_INC%
+echo Converting %1.spv to %1.inc...
+xxd -i %1.spv > %1.inc
 if errorlevel 1 (
-	echo Failed to convert %FRAG_SPV% to %FRAG_INC%.
+	echo Failed to convert %1.spv to %1.inc.
 	exit /b 1
 )
-
-echo Shader compilation and conversion completed successfully.
-endlocal
\ No newline at end of file
+exit /b 0
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 450
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+// Per instance (binding 1, InstanceData): rows of the 3x4 model matrix, then a color tint
+layout(location = 2) in vec4 inModel0;
+layout(location = 3) in vec4 inModel1;
+layout(location = 4) in vec4 inModel2;
+layout(location = 5) in vec4 inTint;
+layout(location = 0) out vec3 vPos;
+layout(location = 1) out vec3 vColor;
+// View-projection times the InstancedMeshObject's own model matrix, pushed once per draw
+layout(push_constant) uniform Object {
+    mat4 mvp;
+} object;
+void main() {
+    vec4 local = vec4(inPosition, 1.0);
+    vec3 world = vec3(dot(inModel0, local), dot(inModel1, local), dot(inModel2, local));
+    vPos = inPosition;
+    vColor = inColor * inTint.rgb;
+    gl_Position = object.mvp * vec4(world, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 0) out vec3 vPos;
+layout(location = 1) out vec3 vColor;
+// The scene's global set (TransformBuffer), binding 0: one transform buffer per frame in
+// flight, as a runtime-sized, partially bound array. The frame picks its own with a push
+// constant and each draw's firstInstance is the object's index.
+layout(set = 0, binding = 0) readonly buffer Transforms {
+    mat4 mvp[];
+} transforms[];
+layout(push_constant) uniform Frame {
+    uint slot;
+} frame;
+void main() {
+    vPos = inPosition;
+    vColor = inColor;
+    gl_Position = transforms[frame.slot].mvp[gl_InstanceIndex] * vec4(inPosition, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 450
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 0) out vec3 vPos;
+layout(location = 1) out vec3 vColor;
+// Pushed by every draw: no buffer write, no descriptor set
+layout(push_constant) uniform Object {
+    mat4 mvp;
+} object;
+void main() {
+    vPos = inPosition;
+    vColor = inColor;
+    gl_Position = object.mvp * vec4(inPosition, 1.0);
+}
\ No newline at end of file